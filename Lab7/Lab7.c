@@ -1,26 +1,39 @@
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
+#include "bigint.h"
+#include "fibonacci.h"
+#include "sieve.h"
+#include "gcd.h"
+#include "../common/primality.h"
+#define FACT_MAX_N 20        // largest n whose n! fits in a long
+#define BIG_FACT_MAX_N 200000  // largest n the menu accepts; 200000! takes under a second
+#define FIB_MAX_TERMS 100000
+#define FIB_BIG_MAX_N 10000000
 long FACT(int *num);
 long FACT_NONREC(int *num);
 void factorial_and_binomial();
-int GCD(int *num1, int *num2);
+unsigned GCD(int *num1, int *num2);
 void gcd_program();
 int FIBO(int *num);
 void fibonacci_program();
+void nth_fibonacci_program();
 int ISPRIME(int *num);
 void prime_program();
 void REVERSE(char *str);
 void reverse_program();
+#ifndef LAB7_NO_MAIN
 int main() {
     int choice;
     char cont;
     while (1) {
         printf("1. Factorial (Recursive & Non-Recursive) + Binomial\n");
-        printf("2. GCD using Recursion\n");
-        printf("3. Fibonacci Series using Recursion\n");
+        printf("2. GCD and LCM\n");
+        printf("3. Fibonacci Series\n");
         printf("4. Prime Numbers in a Range\n");
         printf("5. Reverse a String\n");
-        printf("6. Exit\n");
+        printf("6. Nth Fibonacci Number (exact or mod m)\n");
+        printf("7. Exit\n");
         printf("Enter your choice: ");
         scanf("%d", &choice);
         getchar();
@@ -41,6 +54,9 @@ int main() {
                 reverse_program();
                 break;
             case 6:
+                nth_fibonacci_program();
+                break;
+            case 7:
                 printf("Exiting program... Goodbye!\n");
                 return 0;
             default:
@@ -57,6 +73,7 @@ int main() {
     }
     return 0;
 }
+#endif
 
 long FACT(int *num) {
     if (*num == 0)
@@ -83,29 +100,54 @@ void factorial_and_binomial() {
         printf("Invalid input. r should be <= n and both non-negative.\n");
         return;
     }
-    long fact_n_rec = FACT(&n);
-    long fact_n_nonrec = FACT_NONREC(&n);
-    long fact_r = FACT(&r);
-    int n_r = n - r;
-    long fact_n_r = FACT(&n_r);
-    long binomial = fact_n_rec / (fact_r * fact_n_r);
-    printf("\nUsing Recursion: %d! = %ld\n", n, fact_n_rec);
-    printf("Using Loop: %d! = %ld\n", n, fact_n_nonrec);
-    printf("Binomial Coefficient C(%d, %d) = %ld\n", n, r, binomial);
+    if (n > BIG_FACT_MAX_N) {
+        printf("Invalid input. n should be at most %d.\n", BIG_FACT_MAX_N);
+        return;
+    }
+    BigInt fact, binomial;
+    bigint_init(&fact);
+    bigint_init(&binomial);
+    if (n <= FACT_MAX_N) {
+        long fact_n_rec = FACT(&n);
+        long fact_n_nonrec = FACT_NONREC(&n);
+        printf("\nUsing Recursion: %d! = %ld\n", n, fact_n_rec);
+        printf("Using Loop: %d! = %ld\n", n, fact_n_nonrec);
+    } else if (bigint_factorial(&fact, n)) {
+        printf("\n%d! does not fit in a long, computed exactly:\n%d! = ", n, n);
+        bigint_print(stdout, &fact, BIGINT_SUMMARY_DIGITS);
+        printf("\n");
+    } else {
+        printf("Error: Not enough memory for %d!.\n", n);
+    }
+    if (bigint_binomial(&binomial, n, r)) {
+        printf("Binomial Coefficient C(%d, %d) = ", n, r);
+        bigint_print(stdout, &binomial, BIGINT_SUMMARY_DIGITS);
+        printf("\n");
+    } else {
+        printf("Error: Not enough memory for C(%d, %d).\n", n, r);
+    }
+    bigint_free(&fact);
+    bigint_free(&binomial);
 }
 
-int GCD(int *num1, int *num2) {
-    if (*num2 == 0)
-        return *num1;
-    int temp = *num1 % *num2;
-    return GCD(num2, &temp);
+// The magnitude of the GCD, so GCD(INT_MIN, 0) = 2^31 still fits
+unsigned GCD(int *num1, int *num2) {
+    return (unsigned)gcd_i64(*num1, *num2);
 }
 
 void gcd_program() {
-    int a, b;
+    long long a, b;
     printf("\nEnter two numbers: ");
-    scanf("%d %d", &a, &b);
-    printf("GCD of %d and %d = %d\n", a, b, GCD(&a, &b));
+    scanf("%lld %lld", &a, &b);
+    int64_t x, y;
+    unsigned long long g = gcd_ext(a, b, &x, &y);
+    printf("GCD of %lld and %lld = %llu\n", a, b, g);
+    printf("%lld * (%lld) + %lld * (%lld) = %llu\n", a, (long long)x, b, (long long)y, g);
+    uint64_t lcm;
+    if (lcm_u64(a < 0 ? 0 - (uint64_t)a : (uint64_t)a, b < 0 ? 0 - (uint64_t)b : (uint64_t)b, &lcm))
+        printf("LCM of %lld and %lld = %llu\n", a, b, (unsigned long long)lcm);
+    else
+        printf("LCM of %lld and %lld does not fit in 64 bits.\n", a, b);
 }
 
 int FIBO(int *num) {
@@ -121,32 +163,107 @@ void fibonacci_program() {
     int terms;
     printf("\nEnter number of terms: ");
     scanf("%d", &terms);
+    if (terms > FIB_MAX_TERMS) {
+        printf("Invalid input. At most %d terms can be printed.\n", FIB_MAX_TERMS);
+        return;
+    }
     printf("Fibonacci Series: ");
-    for (int i = 0; i < terms; i++) {
-        printf("%d ", FIBO(&i));
+    FibStream stream;
+    fib_stream_init(&stream);
+    uint64_t term;
+    int i = 0;
+    for (; i < terms && fib_stream_next(&stream, &term); i++) {
+        printf("%llu ", (unsigned long long)term);
+    }
+    if (i < terms) {
+        // the rest no longer fit in 64 bits; the exact series restarts from
+        // F(0) and skips the terms already printed
+        FibBigStream big;
+        int ok = fib_big_stream_init(&big);
+        for (int j = 0; ok && j < terms; j++) {
+            const BigInt *t = fib_big_stream_next(&big);
+            if (!t) {
+                ok = 0;
+            } else if (j >= i) {
+                bigint_print(stdout, t, BIGINT_SUMMARY_DIGITS);
+                printf(" ");
+            }
+        }
+        if (!ok)
+            printf("\nError: Not enough memory for the remaining terms.");
+        fib_big_stream_free(&big);
     }
     printf("\n");
 }
 
-int ISPRIME(int *num) {
-    if (*num < 2)
-        return 0;
-    for (int i = 2; i <= *num / 2; i++) {
-        if (*num % i == 0)
-            return 0;
+void nth_fibonacci_program() {
+    // read signed so a negative entry is rejected rather than wrapped to a huge n or m
+    long long sn, sm;
+    printf("\nEnter n: ");
+    int ok = scanf("%lld", &sn) == 1;
+    if (ok) {
+        printf("Enter modulus m (0 for the exact value): ");
+        ok = scanf("%lld", &sm) == 1;
+    }
+    if (!ok || sn < 0 || sm < 0) {
+        int c;
+        while ((c = getchar()) != '\n' && c != EOF) {}
+        printf("Invalid input. n and m should be non-negative whole numbers.\n");
+        return;
     }
-    return 1;
+    unsigned long long n = (unsigned long long)sn, m = (unsigned long long)sm;
+    if (m > 0) {
+        printf("F(%llu) mod %llu = %llu\n", n, m, (unsigned long long)fib_mod(n, m));
+        return;
+    }
+    if (n > FIB_BIG_MAX_N) {
+        printf("Invalid input. n should be at most %d for the exact value.\n", FIB_BIG_MAX_N);
+        return;
+    }
+    BigInt f;
+    bigint_init(&f);
+    if (fib_big(&f, n)) {
+        printf("F(%llu) = ", n);
+        bigint_print(stdout, &f, BIGINT_SUMMARY_DIGITS);
+        printf("\n");
+    } else {
+        printf("Error: Not enough memory for F(%llu).\n", n);
+    }
+    bigint_free(&f);
+}
+
+int ISPRIME(int *num) {
+    return *num >= 2 && primality_test((uint64_t)*num);
 }
 
 void prime_program() {
-    int start, end;
-    printf("\nEnter range (start end): ");
-    scanf("%d %d", &start, &end);
-    printf("Prime numbers between %d and %d are:\n", start, end);
-    for (int i = start; i <= end; i++) {
-        if (ISPRIME(&i))
-            printf("%d ", i);
+    long long start, end;
+    char mode;
+    printf("\nEnter range (start end, or the same number twice to test one number): ");
+    scanf("%lld %lld", &start, &end);
+    if (start == end && start >= 0) {
+        // one number needs no sieve: Miller-Rabin answers it for any 64-bit value
+        printf("%lld is %s.\n", start, primality_test((uint64_t)start) ? "prime" : "not prime");
+        return;
+    }
+    if (start < 0 || end < start || (unsigned long long)end > SIEVE_MAX) {
+        printf("Invalid input. The range should satisfy 0 <= start <= end <= %llu.\n", SIEVE_MAX);
+        return;
+    }
+    printf("List the primes or only count them? (l/c): ");
+    scanf(" %c", &mode);
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t count;
+    if (mode == 'c' || mode == 'C') {
+        if (sieve_count(start, end, threads, &count))
+            printf("There are %llu primes between %lld and %lld.\n", (unsigned long long)count, start, end);
+        else
+            printf("Error: Not enough memory to sieve this range.\n");
+        return;
     }
+    printf("Prime numbers between %lld and %lld are:\n", start, end);
+    if (!sieve_print(stdout, start, end, threads, &count))
+        printf("\nError: Not enough memory to sieve this range.");
     printf("\n");
 }
 
@@ -0,0 +1,528 @@
+#include <stdlib.h>
+#include <string.h>
+#include "bigint.h"
+
+// Factors per leaf of a product tree; a leaf is multiplied out limb by limb.
+#define PRODUCT_LEAF 16
+
+// Schoolbook multiplication sums products into 64-bit columns and only
+// carries every SCHOOL_ROWS rows: 16 products below 10^18 plus a carried
+// column still fit. a is taken SCHOOL_BLOCK limbs at a time.
+#define SCHOOL_ROWS 16
+#define SCHOOL_BLOCK 64
+
+void bigint_init(BigInt *a) {
+    a->limb = NULL;
+    a->len = 0;
+    a->cap = 0;
+}
+
+void bigint_free(BigInt *a) {
+    free(a->limb);
+    bigint_init(a);
+}
+
+static int reserve(BigInt *a, size_t cap) {
+    if (cap <= a->cap)
+        return 1;
+    size_t grown = a->cap ? a->cap * 2 : 8;
+    if (grown < cap)
+        grown = cap;
+    uint32_t *limb = realloc(a->limb, grown * sizeof(uint32_t));
+    if (!limb)
+        return 0;
+    a->limb = limb;
+    a->cap = grown;
+    return 1;
+}
+
+static void trim(BigInt *a) {
+    while (a->len > 0 && a->limb[a->len - 1] == 0)
+        a->len--;
+}
+
+int bigint_set(BigInt *a, uint64_t value) {
+    if (!reserve(a, 3))
+        return 0;
+    a->len = 0;
+    while (value) {
+        a->limb[a->len++] = (uint32_t)(value % BIGINT_BASE);
+        value /= BIGINT_BASE;
+    }
+    return 1;
+}
+
+int bigint_copy(BigInt *r, const BigInt *a) {
+    if (r == a)
+        return 1;
+    if (!reserve(r, a->len))
+        return 0;
+    if (a->len)
+        memcpy(r->limb, a->limb, a->len * sizeof(uint32_t));
+    r->len = a->len;
+    return 1;
+}
+
+int bigint_to_u64(const BigInt *a, uint64_t *value) {
+    uint64_t v = 0;
+    for (size_t i = a->len; i-- > 0;) {
+        if (v > (UINT64_MAX - a->limb[i]) / BIGINT_BASE)
+            return 0;
+        v = v * BIGINT_BASE + a->limb[i];
+    }
+    *value = v;
+    return 1;
+}
+
+int bigint_cmp(const BigInt *a, const BigInt *b) {
+    if (a->len != b->len)
+        return a->len < b->len ? -1 : 1;
+    for (size_t i = a->len; i-- > 0;) {
+        if (a->limb[i] != b->limb[i])
+            return a->limb[i] < b->limb[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+int bigint_mul_small(BigInt *a, uint32_t m) {
+    if (m == 0) {
+        a->len = 0;
+        return 1;
+    }
+    uint64_t carry = 0;
+    for (size_t i = 0; i < a->len; i++) {
+        uint64_t t = (uint64_t)a->limb[i] * m + carry;
+        a->limb[i] = (uint32_t)(t % BIGINT_BASE);
+        carry = t / BIGINT_BASE;
+    }
+    while (carry) {
+        if (!reserve(a, a->len + 1))
+            return 0;
+        a->limb[a->len++] = (uint32_t)(carry % BIGINT_BASE);
+        carry /= BIGINT_BASE;
+    }
+    return 1;
+}
+
+uint32_t bigint_div_small(BigInt *a, uint32_t d) {
+    uint64_t rem = 0;
+    for (size_t i = a->len; i-- > 0;) {
+        uint64_t cur = rem * BIGINT_BASE + a->limb[i];
+        a->limb[i] = (uint32_t)(cur / d);
+        rem = cur % d;
+    }
+    trim(a);
+    return (uint32_t)rem;
+}
+
+// MULTIPLICATION
+// The kernels work on raw limb arrays. x += y and x -= y need yn <= xn; the
+// subtraction also needs x >= y.
+
+static uint32_t add_to(uint32_t *x, size_t xn, const uint32_t *y, size_t yn) {
+    uint32_t carry = 0;
+    size_t i = 0;
+    for (; i < yn; i++) {
+        uint32_t s = x[i] + y[i] + carry;
+        carry = s >= BIGINT_BASE;
+        x[i] = carry ? s - BIGINT_BASE : s;
+    }
+    for (; carry && i < xn; i++) {
+        uint32_t s = x[i] + 1;
+        carry = s == BIGINT_BASE;
+        x[i] = carry ? 0 : s;
+    }
+    return carry;
+}
+
+static void sub_from(uint32_t *x, size_t xn, const uint32_t *y, size_t yn) {
+    uint32_t borrow = 0;
+    size_t i = 0;
+    for (; i < yn; i++) {
+        uint32_t sub = y[i] + borrow;
+        borrow = x[i] < sub;
+        x[i] = borrow ? x[i] + BIGINT_BASE - sub : x[i] - sub;
+    }
+    for (; borrow && i < xn; i++) {
+        borrow = x[i] == 0;
+        x[i] = borrow ? BIGINT_BASE - 1 : x[i] - 1;
+    }
+}
+
+int bigint_add(BigInt *r, const BigInt *a, const BigInt *b) {
+    if (a->len < b->len) {
+        const BigInt *t = a;
+        a = b;
+        b = t;
+    }
+    size_t na = a->len, nb = b->len;
+    if (!reserve(r, na + 1))
+        return 0;
+    // r may be a or b; each limb is read before it is written
+    uint32_t carry = 0;
+    size_t i = 0;
+    for (; i < nb; i++) {
+        uint32_t s = a->limb[i] + b->limb[i] + carry;
+        carry = s >= BIGINT_BASE;
+        r->limb[i] = carry ? s - BIGINT_BASE : s;
+    }
+    for (; i < na; i++) {
+        uint32_t s = a->limb[i] + carry;
+        carry = s == BIGINT_BASE;
+        r->limb[i] = carry ? 0 : s;
+    }
+    r->limb[na] = carry;
+    r->len = na + carry;
+    return 1;
+}
+
+int bigint_sub(BigInt *r, const BigInt *a, const BigInt *b) {
+    if (r == b && r != a) {
+        BigInt t;
+        bigint_init(&t);
+        int ok = bigint_sub(&t, a, b);
+        bigint_free(r);
+        *r = t;
+        return ok;
+    }
+    if (bigint_cmp(a, b) < 0 || !reserve(r, a->len))
+        return 0;
+    if (r != a)
+        memcpy(r->limb, a->limb, a->len * sizeof(uint32_t));
+    r->len = a->len;
+    sub_from(r->limb, r->len, b->limb, b->len);
+    trim(r);
+    return 1;
+}
+
+static void carry_columns(uint64_t *col, size_t n) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t t = col[i] + carry;
+        col[i] = t % BIGINT_BASE;
+        carry = t / BIGINT_BASE;
+    }
+}
+
+// r[0, na + nb) = a * b for nb < BIGINT_KARATSUBA_CUTOFF
+static void mul_school(uint32_t *r, const uint32_t *a, size_t na, const uint32_t *b, size_t nb) {
+    uint64_t col[SCHOOL_BLOCK + BIGINT_KARATSUBA_CUTOFF];
+    memset(r, 0, (na + nb) * sizeof(uint32_t));
+    for (size_t off = 0; off < na; off += SCHOOL_BLOCK) {
+        size_t len = na - off < SCHOOL_BLOCK ? na - off : SCHOOL_BLOCK;
+        const uint32_t *ab = a + off;
+        memset(col, 0, (len + nb) * sizeof(uint64_t));
+        for (size_t i = 0; i < nb; i++) {
+            uint64_t bi = b[i];
+            uint64_t *ci = col + i;
+            for (size_t j = 0; j < len; j++)
+                ci[j] += ab[j] * bi;
+            if (i % SCHOOL_ROWS == SCHOOL_ROWS - 1)
+                carry_columns(col, len + nb);
+        }
+        carry_columns(col, len + nb);
+
+        uint32_t carry = 0;
+        uint32_t *ro = r + off;
+        size_t i = 0;
+        for (; i < len + nb; i++) {
+            uint32_t s = ro[i] + (uint32_t)col[i] + carry;
+            carry = s >= BIGINT_BASE;
+            ro[i] = carry ? s - BIGINT_BASE : s;
+        }
+        for (; carry && off + i < na + nb; i++) {
+            uint32_t s = ro[i] + 1;
+            carry = s == BIGINT_BASE;
+            ro[i] = carry ? 0 : s;
+        }
+    }
+}
+
+// Scratch limbs kmul needs when its longer operand has n limbs.
+static size_t kara_scratch(size_t n) {
+    size_t total = 0;
+    while (n >= BIGINT_KARATSUBA_CUTOFF) {
+        size_t m = (n + 1) / 2;
+        total += 4 * m + 4;
+        n = m + 1;
+    }
+    return total;
+}
+
+// r[0, na + nb) = a * b for na >= nb. Operands split at m = ceil(na / 2) and
+// z1 = (a0 + a1)(b0 + b1) - z0 - z2 is formed in scratch; when b is too
+// short to split, a is cut into nb-limb chunks that are multiplied in turn.
+static void kmul(uint32_t *r, const uint32_t *a, size_t na, const uint32_t *b, size_t nb,
+                 uint32_t *scratch) {
+    if (nb < BIGINT_KARATSUBA_CUTOFF) {
+        mul_school(r, a, na, b, nb);
+        return;
+    }
+    size_t m = (na + 1) / 2;
+    if (nb <= m) {
+        uint32_t *chunk = scratch, *next = scratch + 2 * nb;
+        memset(r, 0, (na + nb) * sizeof(uint32_t));
+        for (size_t off = 0; off < na; off += nb) {
+            size_t len = na - off < nb ? na - off : nb;
+            if (len == nb)
+                kmul(chunk, a + off, len, b, nb, next);
+            else
+                kmul(chunk, b, nb, a + off, len, next);
+            add_to(r + off, na + nb - off, chunk, len + nb);
+        }
+        return;
+    }
+
+    size_t na1 = na - m, nb1 = nb - m;
+    uint32_t *sa = scratch, *sb = sa + m + 1, *z1 = sb + m + 1, *next = z1 + 2 * m + 2;
+    kmul(r, a, m, b, m, next);
+    kmul(r + 2 * m, a + m, na1, b + m, nb1, next);
+
+    memcpy(sa, a, m * sizeof(uint32_t));
+    sa[m] = add_to(sa, m, a + m, na1);
+    memcpy(sb, b, m * sizeof(uint32_t));
+    sb[m] = add_to(sb, m, b + m, nb1);
+    kmul(z1, sa, m + 1, sb, m + 1, next);
+    sub_from(z1, 2 * m + 2, r, 2 * m);
+    sub_from(z1, 2 * m + 2, r + 2 * m, na1 + nb1);
+
+    // z1 = a0 * b1 + a1 * b0 < 2 * B^na, so its limbs above na + nb - m are zero
+    size_t rest = na + nb - m;
+    add_to(r + m, rest, z1, 2 * m + 2 < rest ? 2 * m + 2 : rest);
+}
+
+int bigint_mul(BigInt *r, const BigInt *a, const BigInt *b) {
+    if (a->len < b->len) {
+        const BigInt *t = a;
+        a = b;
+        b = t;
+    }
+    if (b->len == 0) {
+        r->len = 0;
+        return 1;
+    }
+    size_t len = a->len + b->len;
+    size_t scratchLen = kara_scratch(a->len);
+    uint32_t *out = malloc(len * sizeof(uint32_t));
+    uint32_t *scratch = scratchLen ? malloc(scratchLen * sizeof(uint32_t)) : NULL;
+    if (!out || (scratchLen && !scratch)) {
+        free(out);
+        free(scratch);
+        return 0;
+    }
+    kmul(out, a->limb, a->len, b->limb, b->len, scratch);
+    free(scratch);
+
+    // a or b may be r, so r's limbs are only replaced once the product is done
+    free(r->limb);
+    r->limb = out;
+    r->len = len;
+    r->cap = len;
+    trim(r);
+    return 1;
+}
+
+// PRODUCT TREES
+
+int bigint_product(BigInt *r, const uint32_t *factors, size_t count) {
+    if (count <= PRODUCT_LEAF) {
+        if (!bigint_set(r, 1))
+            return 0;
+        for (size_t i = 0; i < count; i++) {
+            if (!bigint_mul_small(r, factors[i]))
+                return 0;
+        }
+        return 1;
+    }
+    size_t half = count / 2;
+    BigInt right;
+    bigint_init(&right);
+    int ok = bigint_product(r, factors, half) &&
+             bigint_product(&right, factors + half, count - half) &&
+             bigint_mul(r, r, &right);
+    bigint_free(&right);
+    return ok;
+}
+
+// Factors for a product tree, packed several to a limb while they fit.
+typedef struct {
+    uint32_t *factor;
+    size_t count;
+    size_t cap;
+    uint64_t pending;
+    int failed;
+} FactorList;
+
+static void factor_flush(FactorList *list) {
+    if (list->pending <= 1)
+        return;
+    if (list->count == list->cap) {
+        size_t cap = list->cap ? list->cap * 2 : 256;
+        uint32_t *factor = realloc(list->factor, cap * sizeof(uint32_t));
+        if (!factor) {
+            list->failed = 1;
+            return;
+        }
+        list->factor = factor;
+        list->cap = cap;
+    }
+    list->factor[list->count++] = (uint32_t)list->pending;
+    list->pending = 1;
+}
+
+// f must be below BIGINT_BASE
+static void factor_push(FactorList *list, uint64_t f) {
+    if (list->pending * f >= BIGINT_BASE)
+        factor_flush(list);
+    list->pending *= f;
+}
+
+// Primes up to n, from a sieve over the odd numbers
+static uint32_t *primes_upto(uint32_t n, size_t *count) {
+    *count = 0;
+    uint32_t *primes = malloc((n / 2 + 2) * sizeof(uint32_t));
+    unsigned char *composite = calloc(n / 2 + 1, 1);
+    if (!primes || !composite) {
+        free(primes);
+        free(composite);
+        return NULL;
+    }
+    if (n >= 2)
+        primes[(*count)++] = 2;
+    for (uint64_t i = 3; i <= n; i += 2) {
+        if (composite[i / 2])
+            continue;
+        primes[(*count)++] = (uint32_t)i;
+        for (uint64_t j = i * i; j <= n; j += 2 * i)
+            composite[j / 2] = 1;
+    }
+    free(composite);
+    return primes;
+}
+
+// FACTORIALS AND BINOMIALS
+
+int bigint_factorial(BigInt *r, uint32_t n) {
+    if (n >= BIGINT_BASE)
+        return 0;
+    size_t nprimes;
+    uint32_t *primes = primes_upto(n, &nprimes);
+    if (!primes)
+        return 0;
+
+    // n! = ((n/2)!)^2 * swing(n), unrolled from the smallest level up. The
+    // exponent of p in swing(m) is the number of odd m / p^i, so every
+    // prime power in it is at most m.
+    uint32_t levels[32];
+    int depth = 0;
+    for (uint32_t m = n; m >= 2; m /= 2)
+        levels[depth++] = m;
+
+    FactorList list = {NULL, 0, 0, 1, 0};
+    BigInt swing;
+    bigint_init(&swing);
+    int ok = bigint_set(r, 1);
+    for (int d = depth - 1; ok && d >= 0; d--) {
+        uint32_t m = levels[d];
+        list.count = 0;
+        for (size_t i = 0; i < nprimes && primes[i] <= m; i++) {
+            uint32_t p = primes[i], q = m;
+            uint64_t pe = 1;
+            while ((q /= p) > 0) {
+                if (q & 1)
+                    pe *= p;
+            }
+            if (pe > 1)
+                factor_push(&list, pe);
+        }
+        factor_flush(&list);
+        ok = !list.failed && bigint_product(&swing, list.factor, list.count) &&
+             bigint_mul(r, r, r) && bigint_mul(r, r, &swing);
+    }
+    bigint_free(&swing);
+    free(list.factor);
+    free(primes);
+    return ok;
+}
+
+int bigint_binomial(BigInt *r, uint32_t n, uint32_t k) {
+    if (k > n)
+        return bigint_set(r, 0);
+    if (n >= BIGINT_BASE)
+        return 0;
+    if (k > n - k)
+        k = n - k;
+    size_t nprimes;
+    uint32_t *primes = primes_upto(n, &nprimes);
+    if (!primes)
+        return 0;
+
+    // By Kummer's theorem the exponent of p in C(n, k) is the number of
+    // carries when adding k and n - k in base p, one per level where
+    // n / p^i - k / p^i - (n - k) / p^i is 1, so p^e <= n.
+    FactorList list = {NULL, 0, 0, 1, 0};
+    for (size_t i = 0; i < nprimes; i++) {
+        uint32_t p = primes[i], nn = n, kk = k, mm = n - k;
+        uint64_t pe = 1;
+        while (nn >= p) {
+            nn /= p;
+            kk /= p;
+            mm /= p;
+            if (nn - kk - mm)
+                pe *= p;
+        }
+        if (pe > 1)
+            factor_push(&list, pe);
+    }
+    factor_flush(&list);
+    int ok = !list.failed && bigint_product(r, list.factor, list.count);
+    free(list.factor);
+    free(primes);
+    return ok;
+}
+
+// OUTPUT
+
+size_t bigint_digits(const BigInt *a) {
+    if (a->len == 0)
+        return 1;
+    size_t digits = (a->len - 1) * BIGINT_BASE_DIGITS;
+    for (uint32_t top = a->limb[a->len - 1]; top; top /= 10)
+        digits++;
+    return digits;
+}
+
+void bigint_print(FILE *out, const BigInt *a, size_t max_digits) {
+    if (a->len == 0) {
+        fputc('0', out);
+        return;
+    }
+    size_t digits = bigint_digits(a);
+    if (digits <= max_digits) {
+        fprintf(out, "%u", a->limb[a->len - 1]);
+        for (size_t i = a->len - 1; i-- > 0;)
+            fprintf(out, "%09u", a->limb[i]);
+        return;
+    }
+
+    size_t half = max_digits / 2 ? max_digits / 2 : 1;
+    size_t lowLimbs = (half + BIGINT_BASE_DIGITS - 1) / BIGINT_BASE_DIGITS;
+    char *lead = malloc(half + 2 * BIGINT_BASE_DIGITS + 1);
+    char *trail = malloc(lowLimbs * BIGINT_BASE_DIGITS + 1);
+    if (!lead || !trail) {
+        free(lead);
+        free(trail);
+        fprintf(out, "(%zu digits)", digits);
+        return;
+    }
+    size_t used = (size_t)sprintf(lead, "%u", a->limb[a->len - 1]);
+    for (size_t i = a->len - 1; used < half && i-- > 0;)
+        used += (size_t)sprintf(lead + used, "%09u", a->limb[i]);
+    lead[half] = '\0';
+    used = 0;
+    for (size_t i = lowLimbs; i-- > 0;)
+        used += (size_t)sprintf(trail + used, "%09u", a->limb[i]);
+    fprintf(out, "%s...%s (%zu digits)", lead, trail + used - half, digits);
+    free(lead);
+    free(trail);
+}
@@ -0,0 +1,58 @@
+#ifndef BIGINT_H
+#define BIGINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Non-negative integers of any size, stored as base 10^9 limbs so they print
+// without a radix conversion.
+#define BIGINT_BASE 1000000000u
+#define BIGINT_BASE_DIGITS 9
+
+// Below this many limbs (of the shorter operand) multiplication is
+// schoolbook; above it Karatsuba.
+#define BIGINT_KARATSUBA_CUTOFF 48
+
+// Number of digits bigint_print shows before it summarizes a value as its
+// leading and trailing digits.
+#define BIGINT_SUMMARY_DIGITS 100
+
+typedef struct {
+    uint32_t *limb;     // least significant first; len == 0 means zero
+    size_t len;
+    size_t cap;
+} BigInt;
+
+void bigint_init(BigInt *a);
+void bigint_free(BigInt *a);
+int bigint_set(BigInt *a, uint64_t value);
+int bigint_copy(BigInt *r, const BigInt *a);
+int bigint_to_u64(const BigInt *a, uint64_t *value);
+int bigint_cmp(const BigInt *a, const BigInt *b);
+
+// Arithmetic returns 1 on success and 0 if memory ran out. r may be one of
+// the operands. bigint_sub also fails if b > a.
+int bigint_add(BigInt *r, const BigInt *a, const BigInt *b);
+int bigint_sub(BigInt *r, const BigInt *a, const BigInt *b);
+int bigint_mul(BigInt *r, const BigInt *a, const BigInt *b);
+int bigint_mul_small(BigInt *a, uint32_t m);
+uint32_t bigint_div_small(BigInt *a, uint32_t d);
+
+// Product of count small factors, multiplied pairwise as a balanced tree so
+// the large multiplications run on operands of similar size.
+int bigint_product(BigInt *r, const uint32_t *factors, size_t count);
+
+// n! by the prime-swing recursion n! = ((n/2)!)^2 * swing(n), and C(n, k)
+// from the prime factorization given by Legendre's formula, so nothing is
+// ever divided out. n must be below BIGINT_BASE.
+int bigint_factorial(BigInt *r, uint32_t n);
+int bigint_binomial(BigInt *r, uint32_t n, uint32_t k);
+
+size_t bigint_digits(const BigInt *a);
+
+// Prints a in full if it has at most max_digits digits, otherwise as its
+// first and last max_digits / 2 digits and the digit count.
+void bigint_print(FILE *out, const BigInt *a, size_t max_digits);
+
+#endif
@@ -0,0 +1,131 @@
+#include "fibonacci.h"
+
+// SERIES
+
+void fib_stream_init(FibStream *s) {
+    s->cur = 0;
+    s->next = 1;
+    s->index = 0;
+}
+
+int fib_stream_next(FibStream *s, uint64_t *term) {
+    if (s->index > FIB_U64_MAX_N)
+        return 0;
+    *term = s->cur;
+    uint64_t sum = s->cur + s->next;
+    s->cur = s->next;
+    s->next = sum;
+    s->index++;
+    return 1;
+}
+
+static void swap_big(BigInt *x, BigInt *y) {
+    BigInt t = *x;
+    *x = *y;
+    *y = t;
+}
+
+// Starts from F(-1) = 1 and F(0) = 0; each call adds the pair into cur and
+// swaps, so cur is the term being returned and next the one after it.
+int fib_big_stream_init(FibBigStream *s) {
+    bigint_init(&s->cur);
+    bigint_init(&s->next);
+    return bigint_set(&s->cur, 1) && bigint_set(&s->next, 0);
+}
+
+const BigInt *fib_big_stream_next(FibBigStream *s) {
+    if (!bigint_add(&s->cur, &s->cur, &s->next))
+        return NULL;
+    swap_big(&s->cur, &s->next);
+    return &s->cur;
+}
+
+void fib_big_stream_free(FibBigStream *s) {
+    bigint_free(&s->cur);
+    bigint_free(&s->next);
+}
+
+// RANDOM ACCESS
+// Each loop walks n from its top bit down, keeping a = F(k), b = F(k+1) for
+// the bits of n seen so far.
+
+static uint64_t top_bit(uint64_t n) {
+    return n ? (uint64_t)1 << (63 - __builtin_clzll(n)) : 0;
+}
+
+// Wrapping arithmetic is exact mod 2^64, which is F(n) itself when it fits.
+int fib_u64(uint64_t n, uint64_t *value) {
+    if (n > FIB_U64_MAX_N)
+        return 0;
+    uint64_t a = 0, b = 1;
+    for (uint64_t mask = top_bit(n); mask; mask >>= 1) {
+        uint64_t c = a * (2 * b - a);
+        uint64_t d = a * a + b * b;
+        a = (n & mask) ? d : c;
+        b = (n & mask) ? c + d : d;
+    }
+    *value = a;
+    return 1;
+}
+
+static uint64_t add_mod(uint64_t a, uint64_t b, uint64_t m) {
+    return a >= m - b ? a - (m - b) : a + b;
+}
+
+static uint64_t sub_mod(uint64_t a, uint64_t b, uint64_t m) {
+    return a >= b ? a - b : a + (m - b);
+}
+
+static uint64_t mul_mod(uint64_t a, uint64_t b, uint64_t m) {
+    return (uint64_t)((__uint128_t)a * b % m);
+}
+
+uint64_t fib_mod(uint64_t n, uint64_t m) {
+    if (m <= 1)
+        return 0;
+    uint64_t a = 0, b = 1;
+    for (uint64_t mask = top_bit(n); mask; mask >>= 1) {
+        uint64_t c = mul_mod(a, sub_mod(add_mod(b, b, m), a, m), m);
+        uint64_t d = add_mod(mul_mod(a, a, m), mul_mod(b, b, m), m);
+        a = (n & mask) ? d : c;
+        b = (n & mask) ? add_mod(c, d, m) : d;
+    }
+    return a;
+}
+
+int fib_big(BigInt *r, uint64_t n) {
+    BigInt a, b, t, u;
+    bigint_init(&a);
+    bigint_init(&b);
+    bigint_init(&t);
+    bigint_init(&u);
+    int ok = bigint_set(&a, 0) && bigint_set(&b, 1);
+    for (uint64_t mask = top_bit(n); ok && mask; mask >>= 1) {
+        int odd = (n & mask) != 0;
+        if (mask == 1) {
+            // only F(n) itself is needed from the last step
+            if (odd)
+                ok = bigint_mul(&t, &a, &a) && bigint_mul(&u, &b, &b) && bigint_add(&a, &t, &u);
+            else
+                ok = bigint_add(&t, &b, &b) && bigint_sub(&t, &t, &a) && bigint_mul(&a, &a, &t);
+            break;
+        }
+        // t = F(2k), u = F(2k+1)
+        ok = bigint_add(&t, &b, &b) && bigint_sub(&t, &t, &a) && bigint_mul(&t, &t, &a) &&
+             bigint_mul(&u, &a, &a) && bigint_mul(&a, &b, &b) && bigint_add(&u, &u, &a);
+        if (odd) {
+            swap_big(&a, &u);
+            ok = ok && bigint_add(&b, &t, &a);
+        } else {
+            swap_big(&a, &t);
+            swap_big(&b, &u);
+        }
+    }
+    if (ok)
+        swap_big(r, &a);
+    bigint_free(&a);
+    bigint_free(&b);
+    bigint_free(&t);
+    bigint_free(&u);
+    return ok;
+}
@@ -0,0 +1,37 @@
+#ifndef FIBONACCI_H
+#define FIBONACCI_H
+
+#include <stdint.h>
+#include "bigint.h"
+
+// Largest n whose F(n) fits in a uint64_t
+#define FIB_U64_MAX_N 93
+
+// Series generation, one addition per term. fib_stream_next stores the next
+// term and returns 1, or returns 0 once the terms no longer fit in 64 bits.
+typedef struct {
+    uint64_t cur, next;
+    uint64_t index;
+} FibStream;
+
+void fib_stream_init(FibStream *s);
+int fib_stream_next(FibStream *s, uint64_t *term);
+
+// The same series with exact terms. The returned term stays valid until the
+// next call; NULL means memory ran out.
+typedef struct {
+    BigInt cur, next;
+} FibBigStream;
+
+int fib_big_stream_init(FibBigStream *s);
+const BigInt *fib_big_stream_next(FibBigStream *s);
+void fib_big_stream_free(FibBigStream *s);
+
+// Random access by fast doubling, O(log n) steps:
+//   F(2k) = F(k) * (2F(k+1) - F(k)),  F(2k+1) = F(k)^2 + F(k+1)^2
+// fib_u64 returns 0 if F(n) does not fit; fib_mod needs m > 0.
+int fib_u64(uint64_t n, uint64_t *value);
+uint64_t fib_mod(uint64_t n, uint64_t m);
+int fib_big(BigInt *r, uint64_t n);
+
+#endif
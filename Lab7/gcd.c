@@ -0,0 +1,185 @@
+#include <pthread.h>
+#include "gcd.h"
+
+uint64_t gcd_u64(uint64_t a, uint64_t b) {
+    if (a == 0)
+        return b;
+    if (b == 0)
+        return a;
+    int shift = __builtin_ctzll(a | b);
+    a >>= __builtin_ctzll(a);
+    do {
+        b >>= __builtin_ctzll(b);
+        uint64_t lo = a < b ? a : b, hi = a < b ? b : a;
+        a = lo;
+        b = hi - lo;
+    } while (b);
+    return a << shift;
+}
+
+static uint64_t magnitude(int64_t v) {
+    return v < 0 ? 0 - (uint64_t)v : (uint64_t)v;
+}
+
+uint64_t gcd_i64(int64_t a, int64_t b) {
+    return gcd_u64(magnitude(a), magnitude(b));
+}
+
+// Runs on the magnitudes. The coefficients are kept mod 2^64: the ones
+// returned fit in an int64_t, but the last pair computed is +-b/g and +-a/g,
+// which may not.
+uint64_t gcd_ext(int64_t a, int64_t b, int64_t *x, int64_t *y) {
+    uint64_t oldR = magnitude(a), r = magnitude(b);
+    uint64_t oldS = 1, s = 0, oldT = 0, t = 1;
+    while (r) {
+        uint64_t q = oldR / r, tmp;
+        tmp = oldR - q * r;
+        oldR = r;
+        r = tmp;
+        tmp = oldS - q * s;
+        oldS = s;
+        s = tmp;
+        tmp = oldT - q * t;
+        oldT = t;
+        t = tmp;
+    }
+    *x = (int64_t)(a < 0 ? 0 - oldS : oldS);
+    *y = (int64_t)(b < 0 ? 0 - oldT : oldT);
+    return oldR;
+}
+
+int lcm_u64(uint64_t a, uint64_t b, uint64_t *lcm) {
+    if (a == 0 || b == 0) {
+        *lcm = 0;
+        return 1;
+    }
+    return !__builtin_mul_overflow(a / gcd_u64(a, b), b, lcm);
+}
+
+// BATCHES
+
+typedef struct {
+    const uint64_t *values;
+    size_t count;
+    int lcm;
+    uint64_t result;
+    int overflow;
+} GcdChunk;
+
+static void *reduce_chunk(void *arg) {
+    GcdChunk *c = arg;
+    if (!c->lcm) {
+        uint64_t g = 0;
+        for (size_t i = 0; i < c->count && g != 1; i++)
+            g = gcd_u64(g, c->values[i]);
+        c->result = g;
+        return NULL;
+    }
+    uint64_t l = 1;
+    for (size_t i = 0; i < c->count && l != 0; i++) {
+        if (!lcm_u64(l, c->values[i], &l)) {
+            c->overflow = 1;
+            break;
+        }
+    }
+    c->result = l;
+    return NULL;
+}
+
+// Splits values into one chunk per thread and reduces the chunk results on
+// the calling thread, which also takes the first chunk.
+static GcdChunk reduce(const uint64_t *values, size_t count, int threads, int lcm) {
+    if (threads < 1)
+        threads = 1;
+    if ((size_t)threads > count / GCD_BATCH_MIN_CHUNK)
+        threads = count / GCD_BATCH_MIN_CHUNK > 0 ? (int)(count / GCD_BATCH_MIN_CHUNK) : 1;
+
+    GcdChunk chunks[threads];
+    pthread_t tids[threads];
+    int started[threads];
+    size_t per = (count + (size_t)threads - 1) / (size_t)threads;
+    for (int t = 0; t < threads; t++) {
+        size_t from = per * (size_t)t < count ? per * (size_t)t : count;
+        size_t to = from + per < count ? from + per : count;
+        chunks[t] = (GcdChunk){values + from, to - from, lcm, 0, 0};
+        started[t] = t > 0 && pthread_create(&tids[t], NULL, reduce_chunk, &chunks[t]) == 0;
+        if (t > 0 && !started[t])
+            reduce_chunk(&chunks[t]);
+    }
+    reduce_chunk(&chunks[0]);
+
+    GcdChunk total = {NULL, 0, lcm, lcm ? 1 : 0, 0};
+    for (int t = 0; t < threads; t++) {
+        if (started[t])
+            pthread_join(tids[t], NULL);
+        if (!lcm)
+            total.result = gcd_u64(total.result, chunks[t].result);
+        else if (chunks[t].overflow || !lcm_u64(total.result, chunks[t].result, &total.result))
+            total.overflow = 1;
+    }
+    return total;
+}
+
+uint64_t gcd_batch(const uint64_t *values, size_t count, int threads) {
+    return reduce(values, count, threads, 0).result;
+}
+
+int lcm_batch(const uint64_t *values, size_t count, int threads, uint64_t *lcm) {
+    GcdChunk total = reduce(values, count, threads, 1);
+    *lcm = total.result;
+    return !total.overflow;
+}
+
+// BIG INTEGERS
+
+// Trailing zero bits of a, up to the nine its low limb can show
+static int low_twos(const BigInt *a) {
+    uint32_t low = a->limb[0];
+    int tz = low ? __builtin_ctz(low) : 9;
+    return tz < 9 ? tz : 9;
+}
+
+static void drop_twos(BigInt *a) {
+    int tz;
+    while (a->len > 0 && (tz = low_twos(a)) > 0)
+        bigint_div_small(a, 1u << tz);
+}
+
+int gcd_big(BigInt *r, const BigInt *a, const BigInt *b) {
+    if (a->len == 0)
+        return bigint_copy(r, b);
+    if (b->len == 0)
+        return bigint_copy(r, a);
+    BigInt x, y;
+    bigint_init(&x);
+    bigint_init(&y);
+    int ok = bigint_copy(&x, a) && bigint_copy(&y, b);
+
+    unsigned twos = 0;
+    while (ok) {
+        int tx = low_twos(&x), ty = low_twos(&y);
+        int t = tx < ty ? tx : ty;
+        if (t == 0)
+            break;
+        bigint_div_small(&x, 1u << t);
+        bigint_div_small(&y, 1u << t);
+        twos += (unsigned)t;
+    }
+    drop_twos(&x);
+    while (ok && y.len > 0) {
+        drop_twos(&y);
+        if (bigint_cmp(&x, &y) > 0) {
+            BigInt t = x;
+            x = y;
+            y = t;
+        }
+        ok = bigint_sub(&y, &y, &x);
+    }
+    for (; ok && twos > 0; twos -= twos < 29 ? twos : 29)
+        ok = bigint_mul_small(&x, 1u << (twos < 29 ? twos : 29));
+    if (ok)
+        ok = bigint_copy(r, &x);
+    bigint_free(&x);
+    bigint_free(&y);
+    return ok;
+}
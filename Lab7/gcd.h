@@ -0,0 +1,34 @@
+#ifndef GCD_H
+#define GCD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "bigint.h"
+
+// Below this many values per thread the batch reductions stay on one thread
+#define GCD_BATCH_MIN_CHUNK 4096
+
+// Binary (Stein) GCD: common factors of two come out in one shift, then odd
+// values are subtracted and their trailing zeros dropped with one ctz each.
+// gcd(0, 0) is 0.
+uint64_t gcd_u64(uint64_t a, uint64_t b);
+
+// Magnitude of the GCD of signed values; gcd_i64(INT64_MIN, 0) is 2^63.
+uint64_t gcd_i64(int64_t a, int64_t b);
+
+// Extended Euclid: returns g = gcd(a, b) and sets x, y with a*x + b*y = g.
+uint64_t gcd_ext(int64_t a, int64_t b, int64_t *x, int64_t *y);
+
+// lcm(a, b) into *lcm; returns 0 if it does not fit in 64 bits.
+int lcm_u64(uint64_t a, uint64_t b, uint64_t *lcm);
+
+// GCD and LCM of count values, split across threads. gcd_batch stops a chunk
+// early once it reaches 1; lcm_batch returns 0 on overflow.
+uint64_t gcd_batch(const uint64_t *values, size_t count, int threads);
+int lcm_batch(const uint64_t *values, size_t count, int threads, uint64_t *lcm);
+
+// Binary GCD on big integers. Base 10^9 limbs are divisible by 2^9, so up to
+// nine factors of two are divided out per pass. Returns 0 if memory ran out.
+int gcd_big(BigInt *r, const BigInt *a, const BigInt *b);
+
+#endif
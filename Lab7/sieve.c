@@ -0,0 +1,291 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sieve.h"
+
+// Bit k of byte i stands for 30 * i + wheel[k] past the start of a block; a
+// set bit marks a composite.
+static const uint8_t wheel[8] = {1, 7, 11, 13, 17, 19, 23, 29};
+static const int8_t wheelBit[30] = {
+    -1, 0, -1, -1, -1, -1, -1, 1, -1, -1, -1, 2, -1, 3, -1,
+    -1, -1, 4, -1, 5, -1, -1, -1, 6, -1, -1, -1, -1, -1, 7,
+};
+
+// Shared by the workers of one run
+typedef struct {
+    uint64_t start, end;
+    const uint32_t *primes;     // sieving primes from 7 to sqrt(end)
+    const uint8_t *masks;       // 8 per prime, see sieve_run
+    size_t nprimes;
+    size_t segBytes;
+} SieveJob;
+
+typedef struct {
+    const SieveJob *job;
+    uint64_t lo, hi;            // numbers [lo, hi), both multiples of 30
+    uint64_t count;
+    int listing;
+    char *text;
+    size_t textLen, textCap;
+    int failed;
+} SieveWorker;
+
+// Primes from 7 to limit, from a sieve over the odd numbers
+static uint32_t *sieving_primes(uint32_t limit, size_t *count) {
+    *count = 0;
+    uint32_t *primes = malloc((limit / 2 + 1) * sizeof(uint32_t));
+    unsigned char *composite = calloc(limit / 2 + 1, 1);
+    if (!primes || !composite) {
+        free(primes);
+        free(composite);
+        return NULL;
+    }
+    for (uint64_t i = 3; i <= limit; i += 2) {
+        if (composite[i / 2])
+            continue;
+        if (i >= 7)
+            primes[(*count)++] = (uint32_t)i;
+        for (uint64_t j = i * i; j <= limit; j += 2 * i)
+            composite[j / 2] = 1;
+    }
+    free(composite);
+    return primes;
+}
+
+static uint64_t isqrt(uint64_t n) {
+    uint64_t r = (uint64_t)sqrtl((long double)n);
+    while (r * r > n)
+        r--;
+    while ((r + 1) * (r + 1) <= n)
+        r++;
+    return r;
+}
+
+static int append_number(SieveWorker *w, uint64_t n) {
+    if (w->textCap - w->textLen < 22) {
+        size_t cap = w->textCap ? w->textCap * 2 : 1 << 16;
+        char *text = realloc(w->text, cap);
+        if (!text)
+            return 0;
+        w->text = text;
+        w->textCap = cap;
+    }
+    char digits[20];
+    int len = 0;
+    do {
+        digits[len++] = (char)('0' + n % 10);
+        n /= 10;
+    } while (n);
+    char *out = w->text + w->textLen;
+    for (int i = 0; i < len; i++)
+        out[i] = digits[len - 1 - i];
+    out[len] = ' ';
+    w->textLen += (size_t)len + 1;
+    return 1;
+}
+
+// Marks numbers of one byte that are outside [start, end], and 1
+static void clip_byte(uint8_t *byte, uint64_t base, const SieveJob *job) {
+    for (int k = 0; k < 8; k++) {
+        uint64_t n = base + wheel[k];
+        if (n < job->start || n > job->end || n == 1)
+            *byte |= (uint8_t)(1u << k);
+    }
+}
+
+// Sieves [lo, hi) segment by segment. next[8 * i + j] is the byte, counted
+// from lo, of the next multiple p * q of primes[i] with q = wheel[j] mod 30;
+// those multiples are 30p apart, so they step p bytes and always land on
+// the same bit, masks[8 * i + j].
+static void *sieve_block(void *arg) {
+    SieveWorker *w = arg;
+    const SieveJob *job = w->job;
+    uint8_t *seg = malloc(job->segBytes);
+    uint64_t *next = malloc((job->nprimes ? job->nprimes : 1) * 8 * sizeof(uint64_t));
+    if (!seg || !next) {
+        free(seg);
+        free(next);
+        w->failed = 1;
+        return NULL;
+    }
+    for (size_t i = 0; i < job->nprimes; i++) {
+        uint64_t p = job->primes[i];
+        uint64_t q = (w->lo + p - 1) / p;
+        if (q < p)
+            q = p;
+        for (int j = 0; j < 8; j++) {
+            uint64_t qj = q + (wheel[j] + 30 - q % 30) % 30;
+            next[8 * i + j] = (p * qj - w->lo) / 30;
+        }
+    }
+
+    size_t active = 0;
+    uint64_t totalBytes = (w->hi - w->lo) / 30;
+    for (uint64_t segStart = 0; segStart < totalBytes; segStart += job->segBytes) {
+        uint64_t segEnd = segStart + job->segBytes < totalBytes ? segStart + job->segBytes : totalBytes;
+        size_t bytes = (size_t)(segEnd - segStart);
+        uint64_t low = w->lo + 30 * segStart;
+        uint64_t high = w->lo + 30 * segEnd;
+        memset(seg, 0, bytes);
+
+        while (active < job->nprimes &&
+               (uint64_t)job->primes[active] * job->primes[active] < high)
+            active++;
+        for (size_t i = 0; i < active; i++) {
+            uint64_t p = job->primes[i];
+            uint64_t *off = next + 8 * i;
+            const uint8_t *mask = job->masks + 8 * i;
+            for (int j = 0; j < 8; j++) {
+                uint64_t o = off[j];
+                for (; o < segEnd; o += p)
+                    seg[o - segStart] |= mask[j];
+                off[j] = o;
+            }
+        }
+        clip_byte(&seg[0], low, job);
+        clip_byte(&seg[bytes - 1], high - 30, job);
+
+        if (!w->listing) {
+            size_t i = 0;
+            for (; i + 8 <= bytes; i += 8) {
+                uint64_t word;
+                memcpy(&word, seg + i, 8);
+                w->count += (uint64_t)__builtin_popcountll(~word);
+            }
+            for (; i < bytes; i++)
+                w->count += (uint64_t)__builtin_popcount(~seg[i] & 0xffu);
+            continue;
+        }
+        for (size_t i = 0; i < bytes; i++) {
+            unsigned bits = ~seg[i] & 0xffu;
+            while (bits) {
+                int k = __builtin_ctz(bits);
+                bits &= bits - 1;
+                if (!append_number(w, low + 30 * i + wheel[k])) {
+                    w->failed = 1;
+                    goto done;
+                }
+                w->count++;
+            }
+        }
+    }
+done:
+    free(seg);
+    free(next);
+    return NULL;
+}
+
+// Runs the workers on consecutive blocks of bytes wheel bytes from lo; the
+// calling thread takes the first block.
+static int run_workers(SieveWorker *workers, int threads, uint64_t lo, uint64_t bytes) {
+    uint64_t per = (bytes + (uint64_t)threads - 1) / (uint64_t)threads;
+    pthread_t tids[threads];
+    int started[threads];
+    for (int t = 0; t < threads; t++) {
+        uint64_t from = per * (uint64_t)t < bytes ? per * (uint64_t)t : bytes;
+        uint64_t to = from + per < bytes ? from + per : bytes;
+        workers[t].lo = lo + 30 * from;
+        workers[t].hi = lo + 30 * to;
+        workers[t].textLen = 0;
+        started[t] = 0;
+        if (t > 0 && to > from)
+            started[t] = pthread_create(&tids[t], NULL, sieve_block, &workers[t]) == 0;
+        if (t > 0 && to > from && !started[t])
+            sieve_block(&workers[t]);
+    }
+    if (bytes > 0)
+        sieve_block(&workers[0]);
+    int ok = 1;
+    for (int t = 0; t < threads; t++) {
+        if (started[t])
+            pthread_join(tids[t], NULL);
+        if (workers[t].failed)
+            ok = 0;
+    }
+    return ok;
+}
+
+static int sieve_run(FILE *out, uint64_t start, uint64_t end, int threads, uint64_t *count) {
+    *count = 0;
+    if (end > SIEVE_MAX)
+        return 0;
+    if (start > end)
+        return 1;
+
+    const uint64_t small[3] = {2, 3, 5};
+    for (int i = 0; i < 3; i++) {
+        if (small[i] >= start && small[i] <= end) {
+            (*count)++;
+            if (out)
+                fprintf(out, "%llu ", (unsigned long long)small[i]);
+        }
+    }
+    if (end < 7)
+        return 1;
+
+    SieveJob job;
+    job.start = start;
+    job.end = end;
+    uint32_t *primes = sieving_primes((uint32_t)isqrt(end), &job.nprimes);
+    uint8_t *masks = malloc((job.nprimes ? job.nprimes : 1) * 8);
+    if (!primes || !masks) {
+        free(primes);
+        free(masks);
+        return 0;
+    }
+    for (size_t i = 0; i < job.nprimes; i++) {
+        for (int j = 0; j < 8; j++)
+            masks[8 * i + j] = (uint8_t)(1u << wheelBit[primes[i] % 30 * wheel[j] % 30]);
+    }
+    job.primes = primes;
+    job.masks = masks;
+    job.segBytes = SIEVE_L1_BYTES;
+    while (job.segBytes < SIEVE_L2_BYTES && job.segBytes < isqrt(end) / 4)
+        job.segBytes *= 2;
+
+    if (threads < 1)
+        threads = 1;
+    SieveWorker *workers = calloc((size_t)threads, sizeof(SieveWorker));
+    if (!workers) {
+        free(primes);
+        free(masks);
+        return 0;
+    }
+    for (int t = 0; t < threads; t++) {
+        workers[t].job = &job;
+        workers[t].listing = out != NULL;
+    }
+
+    // Counting runs one block per thread over the whole range; listing goes
+    // in rounds so the text held at once stays bounded.
+    uint64_t lo = start / 30 * 30;
+    uint64_t totalBytes = end / 30 + 1 - start / 30;
+    uint64_t batch = out ? (uint64_t)threads * SIEVE_BATCH_SEGMENTS * job.segBytes : totalBytes;
+    int ok = 1;
+    for (uint64_t done = 0; ok && done < totalBytes; done += batch) {
+        uint64_t bytes = totalBytes - done < batch ? totalBytes - done : batch;
+        ok = run_workers(workers, threads, lo + 30 * done, bytes);
+        for (int t = 0; t < threads; t++) {
+            *count += workers[t].count;
+            workers[t].count = 0;
+            if (ok && out && workers[t].textLen)
+                fwrite(workers[t].text, 1, workers[t].textLen, out);
+        }
+    }
+
+    for (int t = 0; t < threads; t++)
+        free(workers[t].text);
+    free(workers);
+    free(primes);
+    free(masks);
+    return ok;
+}
+
+int sieve_count(uint64_t start, uint64_t end, int threads, uint64_t *count) {
+    return sieve_run(NULL, start, end, threads, count);
+}
+
+int sieve_print(FILE *out, uint64_t start, uint64_t end, int threads, uint64_t *count) {
+    return sieve_run(out, start, end, threads, count);
+}
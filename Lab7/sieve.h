@@ -0,0 +1,28 @@
+#ifndef SIEVE_H
+#define SIEVE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Largest end of a range the sieve accepts
+#define SIEVE_MAX 1000000000000ull
+
+// Segments are sized between the L1 and L2 data caches: L1 when the sieving
+// primes are few, growing towards L2 as sqrt(end) grows so each segment is
+// still hit by most primes. One byte holds the 8 numbers in 30 that are
+// coprime to 2, 3 and 5.
+#define SIEVE_L1_BYTES 32768
+#define SIEVE_L2_BYTES 262144
+
+// Segments each thread sieves per round when listing; rounds are written out
+// in order before the next starts.
+#define SIEVE_BATCH_SEGMENTS 8
+
+// Segmented Sieve of Eratosthenes over [start, end], split across threads.
+// sieve_count only counts; sieve_print also writes the primes to out,
+// separated by spaces. Both return 0 if the range is invalid or memory ran
+// out.
+int sieve_count(uint64_t start, uint64_t end, int threads, uint64_t *count);
+int sieve_print(FILE *out, uint64_t start, uint64_t end, int threads, uint64_t *count);
+
+#endif
@@ -1,16 +1,10 @@
  #include <stdio.h>
+#include "../common/primality.h"
 
 int num;//declared global var
 
 int prime() {
-    int i;
-    if (num <= 1)
-        return 0;
-    for (i = 2; i * i <= num; i++) {
-        if (num % i == 0)
-            return 0;
-    }
-    return 1;
+    return num > 1 && primality_test((uint64_t)num);
 }
 
 int armstrong() {
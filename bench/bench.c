@@ -0,0 +1,48 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench.h"
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+void benchStart(BenchState *st) {
+    st->started = now();
+}
+
+void benchStop(BenchState *st) {
+    st->elapsed += now() - st->started;
+}
+
+void benchRunAll(const Benchmark *benchmarks, size_t count, const char *filter) {
+    printf("%-32s %14s %16s %10s\n", "Benchmark", "Time/iter", "Items/sec", "Iterations");
+    for (size_t b = 0; b < count; b++) {
+        for (int s = 0; s < BENCH_MAX_SIZES && benchmarks[b].sizes[s]; s++) {
+            char name[64];
+            snprintf(name, sizeof(name), "%s/%ld", benchmarks[b].name, benchmarks[b].sizes[s]);
+            if (filter && !strstr(name, filter)) continue;
+
+            BenchState st;
+            memset(&st, 0, sizeof(st));
+            st.n = benchmarks[b].sizes[s];
+            long iterations = 0;
+            while (st.elapsed < MIN_TIME && !st.failed) {
+                benchmarks[b].fn(&st);
+                iterations++;
+            }
+            if (st.failed) {
+                printf("%-32s %14s\n", name, "setup failed");
+                fflush(stdout);
+                continue;
+            }
+            double perIter = st.elapsed / iterations;
+            printf("%-32s %11.3f ms %16.0f %10ld\n", name, perIter * 1e3,
+                   perIter > 0 ? st.items / perIter : 0.0, iterations);
+            fflush(stdout);
+        }
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h>
+
+// Harness shared by the benchmark programs. A benchmark repeats until it has
+// been timed for at least MIN_TIME seconds and reports the mean per iteration.
+#define MIN_TIME 0.5
+#define BENCH_MAX_SIZES 6
+
+typedef struct {
+    long n;             // problem size
+    long items;         // work items per iteration, for the rate column
+    double elapsed;     // timed seconds so far
+    double started;
+    int failed;         // set by a benchmark whose setup failed; it is skipped
+} BenchState;
+
+typedef void (*BenchFn)(BenchState *st);
+
+typedef struct {
+    const char *name;
+    BenchFn fn;
+    long sizes[BENCH_MAX_SIZES];    // 0-terminated
+} Benchmark;
+
+// Brackets the timed part of one iteration.
+void benchStart(BenchState *st);
+void benchStop(BenchState *st);
+
+// Runs every size of every benchmark whose "name/size" contains filter (all
+// of them if filter is NULL) and prints one line each.
+void benchRunAll(const Benchmark *benchmarks, size_t count, const char *filter);
+
+#endif
@@ -0,0 +1,304 @@
+// Benchmarks for the hrst game core. Build and run with `make run-bench`;
+// pass a substring to run only matching benchmarks, e.g.
+//
+//   build/bench_hrst profiles/load
+//
+// Each benchmark runs in a scratch directory, since the game keeps its data
+// files in the working directory. A benchmark repeats until it has been
+// timed for at least MIN_TIME seconds and reports the mean per iteration.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "hrst.h"
+
+static void removeDataFiles(void) {
+    const char *files[] = {PROFILE_FILE, HIGHSCORE_FILE, LEADERBOARD_FILE, LEADERBOARD_TOP_FILE,
+                           STATS_FILE, ANALYTICS_FILE, LOCK_FILE, TOURNAMENT_FILE};
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) unlink(files[i]);
+}
+
+// Returns 0 if the store could not be opened or filled.
+static int fillProfiles(long n) {
+    ProfileStore store;
+    if (!loadProfiles(&store)) return 0;
+    Profile p;
+    memset(&p, 0, sizeof(p));
+    int ok = 1;
+    for (long i = 0; ok && i < n; i++) {
+        snprintf(p.name, MAX_NAME_LEN, "player%ld", i);
+        ok = storeAddProfile(&store, &p);
+    }
+    closeProfiles(&store);
+    return ok;
+}
+
+// Creating n profiles in an empty store
+static void benchProfilesSave(BenchState *st) {
+    removeDataFiles();
+    benchStart(st);
+    st->failed = !fillProfiles(st->n);
+    benchStop(st);
+    st->items = st->n;
+}
+
+// Opening a store of n profiles and building its name index
+static void benchProfilesLoad(BenchState *st) {
+    static long filled = -1;
+    if (filled != st->n) {
+        removeDataFiles();
+        if (!fillProfiles(st->n)) {
+            st->failed = 1;
+            return;
+        }
+        filled = st->n;
+    }
+    ProfileStore store;
+    benchStart(st);
+    if (loadProfiles(&store)) {
+        findProfileIndex(&store, "player0");
+        closeProfiles(&store);
+    } else {
+        st->failed = 1;
+    }
+    benchStop(st);
+    st->items = st->n;
+}
+
+// A store of n profiles kept open across iterations, for the search cases.
+// NULL if it could not be built.
+static ProfileStore *searchStore(long n) {
+    static ProfileStore store;
+    static long filled = -1;
+    if (filled != n) {
+        if (filled != -1) closeProfiles(&store);
+        filled = -1;
+        removeDataFiles();
+        if (!fillProfiles(n) || !loadProfiles(&store)) return NULL;
+        filled = n;
+    }
+    return &store;
+}
+
+// 1000 prefix lookups, each matching up to ten names
+static void benchProfilesPrefix(BenchState *st) {
+    ProfileStore *store = searchStore(st->n);
+    if (!store) {
+        st->failed = 1;
+        return;
+    }
+    char prefix[MAX_NAME_LEN];
+    int first;
+    volatile int sink = 0;
+    benchStart(st);
+    for (int q = 0; q < 1000; q++) {
+        snprintf(prefix, sizeof(prefix), "player%ld", (q * 7919L) % (st->n / 10 + 1));
+        sink += profilePrefixSearch(store, prefix, &first);
+    }
+    benchStop(st);
+    (void)sink;
+    st->items = 1000;
+}
+
+// 100 misspelled-name lookups within two edits
+static void benchProfilesFuzzy(BenchState *st) {
+    ProfileStore *store = searchStore(st->n);
+    if (!store) {
+        st->failed = 1;
+        return;
+    }
+    char query[MAX_NAME_LEN];
+    int out[PROFILE_SEARCH_LIMIT];
+    volatile int sink = 0;
+    benchStart(st);
+    for (int q = 0; q < 100; q++) {
+        snprintf(query, sizeof(query), "playr%ld", (q * 7919L) % st->n);
+        sink += profileFuzzySearch(store, query, 2, out, PROFILE_SEARCH_LIMIT);
+    }
+    benchStop(st);
+    (void)sink;
+    st->items = 100;
+}
+
+// Building the leaderboard from a score log of n lines over n/8 players
+static void benchScoreboard(BenchState *st) {
+    static long written = -1;
+    if (written != st->n) {
+        removeDataFiles();
+        FILE *fp = fopen(HIGHSCORE_FILE, "w");
+        if (!fp) {
+            st->failed = 1;
+            return;
+        }
+        for (long i = 0; i < st->n; i++) {
+            fprintf(fp, "player%ld %d %d %d\n", i % (st->n / 8 + 1), 10, (int)(i % 11), 10 - (int)(i % 11));
+        }
+        fclose(fp);
+        written = st->n;
+    }
+    unlink(LEADERBOARD_FILE);
+    unlink(LEADERBOARD_TOP_FILE);
+    Leaderboard lb;
+    benchStart(st);
+    if (openLeaderboard(&lb)) {
+        closeLeaderboard(&lb);
+    } else {
+        st->failed = 1;
+    }
+    benchStop(st);
+    st->items = st->n;
+}
+
+static void benchComputerMove(BenchState *st) {
+    Rng rng;
+    rngSeed(&rng, RNG_XOSHIRO, 42);
+    volatile int sink = 0;
+    benchStart(st);
+    for (long i = 0; i < st->n; i++) sink += computerMove(&rng, 1 + (int)(i & 1));
+    benchStop(st);
+    (void)sink;
+    st->items = st->n;
+}
+
+// n complete 10-round games through the simulation core, no I/O
+static void benchSessionSimulated(BenchState *st) {
+    SimJob job;
+    memset(&job, 0, sizeof(job));
+    job.strategy = findStrategy("random");
+    job.mode = 1;
+    job.rounds = 10;
+    job.games = st->n;
+    job.opponent = OPPONENT_ADAPTIVE;
+    rngSeed(&job.rng, RNG_XOSHIRO, 42);
+    benchStart(st);
+    simulateGames(&job);
+    benchStop(st);
+    st->items = st->n;
+}
+
+// n complete 10-round games, each saved like a played game: score log,
+// profile, stats log and leaderboard, synced every DEFAULT_SYNC_BATCH games
+static void benchSessionRecorded(BenchState *st) {
+    removeDataFiles();
+    ProfileStore store;
+    Leaderboard lb;
+    if (!loadProfiles(&store)) {
+        st->failed = 1;
+        return;
+    }
+    if (!openLeaderboard(&lb)) {
+        closeProfiles(&store);
+        st->failed = 1;
+        return;
+    }
+    durableAttach(&store, &lb);
+    Rng rng;
+    rngSeed(&rng, RNG_XOSHIRO, 42);
+    OpponentModel model;
+    memset(&model, 0, sizeof(model));
+
+    benchStart(st);
+    for (long g = 0; g < st->n; g++) {
+        GameSession session;
+        memset(&session, 0, sizeof(session));
+        snprintf(session.playerName, MAX_NAME_LEN, "player%ld", g % 100);
+        session.roundsPlayed = 10;
+        for (int r = 0; r < 10; r++) {
+            Move playerMove = computerMove(&rng, 1);
+            Move compMove = opponentMove(&model, &rng, 1, session.movesHistory, r);
+            modelLearn(&model, 1, session.movesHistory, r, playerMove);
+            setHistoryMove(&session.movesHistory, r, playerMove);
+            setHistoryMove(&session.compMovesHistory, r, compMove);
+            if (scoreRound(playerMove, compMove)) {
+                session.wins++;
+            } else {
+                session.losses++;
+            }
+        }
+        recordGameResult(&store, &lb, &session, 1, NULL, &model);
+    }
+    durableShutdown();
+    benchStop(st);
+
+    closeLeaderboard(&lb);
+    closeProfiles(&store);
+    st->items = st->n;
+}
+
+// Logs n adaptive sessions spread over 1000 players, as the game would
+static void fillSessionLog(long n) {
+    static OpponentModel models[1000];
+    memset(models, 0, sizeof(models));
+    Rng rng;
+    rngSeed(&rng, RNG_XOSHIRO, 42);
+    for (long g = 0; g < n; g++) {
+        GameSession session;
+        memset(&session, 0, sizeof(session));
+        snprintf(session.playerName, MAX_NAME_LEN, "player%ld", g % 1000);
+        session.roundsPlayed = 10;
+        Rng game;
+        seedSession(&session, &game, &rng, OPPONENT_ADAPTIVE);
+        OpponentModel *model = &models[g % 1000];
+        for (int r = 0; r < 10; r++) {
+            Move playerMove = computerMove(&rng, 1);
+            Move compMove = opponentMove(model, &game, 1, session.movesHistory, r);
+            modelLearn(model, 1, session.movesHistory, r, playerMove);
+            setHistoryMove(&session.movesHistory, r, playerMove);
+            setHistoryMove(&session.compMovesHistory, r, compMove);
+            session.wins += scoreRound(playerMove, compMove);
+        }
+        session.losses = 10 - session.wins;
+        saveGameStats(&session, 1);
+    }
+    durableShutdown();
+}
+
+// Re-running n logged sessions through the game core and checking each one
+static void benchReplayVerify(BenchState *st) {
+    static long filled = -1;
+    if (filled != st->n) {
+        removeDataFiles();
+        fillSessionLog(st->n);
+        filled = st->n;
+    }
+    ReplayReport rep;
+    benchStart(st);
+    st->failed = !verifyLog(STATS_FILE, (int)sysconf(_SC_NPROCESSORS_ONLN), &rep);
+    benchStop(st);
+    if (rep.verified != st->n) {
+        printf("replay/verify: only %ld of %ld sessions replayed exactly\n", rep.verified, st->n);
+    }
+    st->items = st->n;
+}
+
+static const Benchmark benchmarks[] = {
+    {"profiles/save", benchProfilesSave, {1000, 10000, 100000, 1000000, 0}},
+    {"profiles/load", benchProfilesLoad, {1000, 10000, 100000, 1000000, 0}},
+    {"profiles/prefix", benchProfilesPrefix, {1000, 10000, 100000, 1000000, 0}},
+    {"profiles/fuzzy", benchProfilesFuzzy, {1000, 10000, 100000, 1000000, 0}},
+    {"scoreboard/catch-up", benchScoreboard, {1000, 10000, 100000, 1000000, 0}},
+    {"computerMove", benchComputerMove, {10000000, 0}},
+    {"session/simulated", benchSessionSimulated, {100000, 0}},
+    {"session/recorded", benchSessionRecorded, {1000, 10000, 0}},
+    {"replay/verify", benchReplayVerify, {100000, 1000000, 0}},
+};
+
+int main(int argc, char *argv[]) {
+    const char *filter = argc > 1 ? argv[1] : NULL;
+    char dir[] = "/tmp/hrst-bench-XXXXXX";
+    if (!mkdtemp(dir) || chdir(dir) != 0) {
+        printf("Error: Could not create a scratch directory.\n");
+        return 1;
+    }
+
+    benchRunAll(benchmarks, sizeof(benchmarks) / sizeof(benchmarks[0]), filter);
+
+    removeDataFiles();
+    if (chdir("/") != 0 || rmdir(dir) != 0) {
+        printf("Warning: Could not remove the scratch directory %s.\n", dir);
+        return 1;
+    }
+    return 0;
+}
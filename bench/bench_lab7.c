@@ -0,0 +1,612 @@
+// Benchmarks for the Lab7 programs. Build and run with `make run-bench`;
+// pass a substring to run only matching benchmarks, e.g.
+//
+//   build/bench_lab7 factorial
+//
+// Lab7.c is built with -DLAB7_NO_MAIN so its functions can be called
+// directly. A benchmark repeats until it has been timed for at least
+// MIN_TIME seconds and reports the mean per iteration.
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "bigint.h"
+#include "fibonacci.h"
+#include "sieve.h"
+#include "primality.h"
+#include "gcd.h"
+
+// From Lab7/Lab7.c
+long FACT(int *num);
+long FACT_NONREC(int *num);
+int FIBO(int *num);
+int ISPRIME(int *num);
+unsigned GCD(int *num1, int *num2);
+
+// Keeps results observable so the timed calls are not optimized away
+static volatile long sink;
+
+// FACTORIALS
+
+// n! one multiplication at a time, the way FACT_NONREC does it
+static void naiveFactorial(BigInt *r, long n) {
+    bigint_set(r, 1);
+    for (long i = 2; i <= n; i++) bigint_mul_small(r, (uint32_t)i);
+}
+
+// C(n, k) as the running product (n - k + i) / i, each division exact
+static void naiveBinomial(BigInt *r, long n, long k) {
+    if (k > n - k) k = n - k;
+    bigint_set(r, 1);
+    for (long i = 1; i <= k; i++) {
+        bigint_mul_small(r, (uint32_t)(n - k + i));
+        bigint_div_small(r, (uint32_t)i);
+    }
+}
+
+// FACT on long, called for n up to its overflow limit of 20
+static void benchFactRecursive(BenchState *st) {
+    int n = (int)st->n;
+    benchStart(st);
+    for (int i = 0; i < 100000; i++) sink += FACT(&n);
+    benchStop(st);
+    st->items = 100000;
+}
+
+static void benchFactLoop(BenchState *st) {
+    int n = (int)st->n;
+    benchStart(st);
+    for (int i = 0; i < 100000; i++) sink += FACT_NONREC(&n);
+    benchStop(st);
+    st->items = 100000;
+}
+
+static void benchFactorialNaive(BenchState *st) {
+    BigInt r;
+    bigint_init(&r);
+    benchStart(st);
+    naiveFactorial(&r, st->n);
+    benchStop(st);
+    sink += (long)r.len;
+    bigint_free(&r);
+    st->items = 1;
+}
+
+static void benchFactorialSwing(BenchState *st) {
+    BigInt r;
+    bigint_init(&r);
+    benchStart(st);
+    bigint_factorial(&r, (uint32_t)st->n);
+    benchStop(st);
+    sink += (long)r.len;
+    bigint_free(&r);
+    st->items = 1;
+}
+
+// BINOMIALS, all C(n, n / 2)
+
+static void benchBinomialNaive(BenchState *st) {
+    BigInt r;
+    bigint_init(&r);
+    benchStart(st);
+    naiveBinomial(&r, st->n, st->n / 2);
+    benchStop(st);
+    sink += (long)r.len;
+    bigint_free(&r);
+    st->items = 1;
+}
+
+static void benchBinomialPrime(BenchState *st) {
+    BigInt r;
+    bigint_init(&r);
+    benchStart(st);
+    bigint_binomial(&r, (uint32_t)st->n, (uint32_t)(st->n / 2));
+    benchStop(st);
+    sink += (long)r.len;
+    bigint_free(&r);
+    st->items = 1;
+}
+
+// FIBONACCI
+
+// The first n terms, one FIBO call each, as fibonacci_program used to
+static void benchFiboSeries(BenchState *st) {
+    int terms = (int)st->n;
+    benchStart(st);
+    for (int i = 0; i < terms; i++) sink += FIBO(&i);
+    benchStop(st);
+    st->items = terms;
+}
+
+static void benchFibStream(BenchState *st) {
+    benchStart(st);
+    for (int rep = 0; rep < 10000; rep++) {
+        FibStream s;
+        fib_stream_init(&s);
+        uint64_t term;
+        for (long i = 0; i < st->n && fib_stream_next(&s, &term); i++) sink += (long)term;
+    }
+    benchStop(st);
+    st->items = 10000 * st->n;
+}
+
+static void benchFibBigStream(BenchState *st) {
+    FibBigStream s;
+    fib_big_stream_init(&s);
+    benchStart(st);
+    for (long i = 0; i < st->n; i++) sink += (long)fib_big_stream_next(&s)->len;
+    benchStop(st);
+    fib_big_stream_free(&s);
+    st->items = st->n;
+}
+
+static void benchFibDoubling(BenchState *st) {
+    BigInt r;
+    bigint_init(&r);
+    benchStart(st);
+    fib_big(&r, (uint64_t)st->n);
+    benchStop(st);
+    sink += (long)r.len;
+    bigint_free(&r);
+    st->items = 1;
+}
+
+// F(n) mod 10^9 + 7 for st->n indices spread over the 64-bit range
+static void benchFibMod(BenchState *st) {
+    uint64_t n = 0x9e3779b97f4a7c15ull;
+    benchStart(st);
+    for (long i = 0; i < st->n; i++) {
+        sink += (long)fib_mod(n, 1000000007);
+        n = n * 6364136223846793005ull + 1442695040888963407ull;
+    }
+    benchStop(st);
+    st->items = st->n;
+}
+
+// PRIMES IN A RANGE, all over [0, n]
+
+// ISPRIME on every number, as prime_program used to
+static void benchIsPrimeRange(BenchState *st) {
+    int n = (int)st->n;
+    benchStart(st);
+    for (int i = 0; i <= n; i++) sink += ISPRIME(&i);
+    benchStop(st);
+    st->items = st->n;
+}
+
+static int threadCount(void) {
+    return (int)sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+static void benchSieveCount(BenchState *st) {
+    uint64_t count;
+    benchStart(st);
+    sieve_count(0, (uint64_t)st->n, threadCount(), &count);
+    benchStop(st);
+    sink += (long)count;
+    st->items = st->n;
+}
+
+static void benchSieveList(BenchState *st) {
+    static FILE *devNull;
+    if (!devNull) devNull = fopen("/dev/null", "w");
+    uint64_t count;
+    benchStart(st);
+    sieve_print(devNull, 0, (uint64_t)st->n, threadCount(), &count);
+    benchStop(st);
+    sink += (long)count;
+    st->items = st->n;
+}
+
+static int checkSieve(void) {
+    const uint64_t known[][2] = {{10, 4}, {1000, 168}, {1000000, 78498}, {100000000, 5761455}};
+    int ok = 1;
+    for (size_t i = 0; i < sizeof(known) / sizeof(known[0]); i++) {
+        uint64_t count;
+        if (!sieve_count(0, known[i][0], threadCount(), &count) || count != known[i][1]) {
+            printf("check: sieve_count found %llu primes up to %llu\n", (unsigned long long)count,
+                   (unsigned long long)known[i][0]);
+            ok = 0;
+        }
+    }
+    // windows that do not start on a wheel boundary, against ISPRIME
+    for (int start = 0; start < 5000; start += 37) {
+        uint64_t count, slow = 0;
+        sieve_count((uint64_t)start, (uint64_t)start + 200, 2, &count);
+        for (int i = start; i <= start + 200; i++) slow += (uint64_t)ISPRIME(&i);
+        if (count != slow) {
+            printf("check: sieve_count(%d, %d) disagrees with ISPRIME\n", start, start + 200);
+            ok = 0;
+        }
+    }
+    return ok;
+}
+
+// PRIMALITY OF SINGLE NUMBERS, on random odd n-bit candidates
+
+#define PRIMALITY_INPUTS 4096
+
+static uint64_t candidates[PRIMALITY_INPUTS];
+static unsigned char verdicts[PRIMALITY_INPUTS];
+
+// Trial division to sqrt(n), as Practice/menu.c's prime() did
+static int trialDivision(uint64_t n) {
+    if (n < 2) return 0;
+    for (uint64_t d = 2; d * d <= n; d++) {
+        if (n % d == 0) return 0;
+    }
+    return 1;
+}
+
+static void fillCandidates(int bits) {
+    uint64_t x = 0x2545f4914f6cdd1dull + (uint64_t)bits;
+    for (int i = 0; i < PRIMALITY_INPUTS; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        uint64_t top = (uint64_t)1 << (bits - 1);
+        candidates[i] = ((x & (top - 1)) | top | 1);
+    }
+}
+
+static void benchTrialDivision(BenchState *st) {
+    fillCandidates((int)st->n);
+    benchStart(st);
+    for (int i = 0; i < PRIMALITY_INPUTS; i++) sink += trialDivision(candidates[i]);
+    benchStop(st);
+    st->items = PRIMALITY_INPUTS;
+}
+
+static void benchMillerRabin(BenchState *st) {
+    fillCandidates((int)st->n);
+    benchStart(st);
+    for (int i = 0; i < PRIMALITY_INPUTS; i++) sink += primality_test(candidates[i]);
+    benchStop(st);
+    st->items = PRIMALITY_INPUTS;
+}
+
+static void benchPrimalityBatch(BenchState *st) {
+    fillCandidates((int)st->n);
+    benchStart(st);
+    primality_test_batch(candidates, verdicts, PRIMALITY_INPUTS);
+    benchStop(st);
+    sink += verdicts[0];
+    st->items = PRIMALITY_INPUTS;
+}
+
+static int checkPrimality(void) {
+    int ok = 1;
+    for (uint64_t n = 0; n < 200000; n++) {
+        if (primality_test(n) != trialDivision(n)) {
+            printf("check: primality_test(%llu) disagrees with trial division\n", (unsigned long long)n);
+            ok = 0;
+        }
+    }
+    // strong pseudoprimes to several prime bases, and the largest 64-bit prime
+    const uint64_t composites[] = {3215031751ull, 2152302898747ull, 3474749660383ull,
+                                   341550071728321ull, 3825123056546413051ull, 18446744073709551615ull};
+    for (size_t i = 0; i < sizeof(composites) / sizeof(composites[0]); i++) {
+        if (primality_test(composites[i])) {
+            printf("check: %llu passed as prime\n", (unsigned long long)composites[i]);
+            ok = 0;
+        }
+    }
+    if (!primality_test(18446744073709551557ull)) {
+        printf("check: 2^64 - 59 failed as composite\n");
+        ok = 0;
+    }
+
+    // a window near 10^12 against the sieve, singly and in a batch
+    const uint64_t from = 999999000000ull, width = 100000;
+    uint64_t sieved, single = 0, batched = 0;
+    sieve_count(from, from + width - 1, 1, &sieved);
+    uint64_t *values = malloc(width * sizeof(uint64_t));
+    unsigned char *results = malloc(width);
+    for (uint64_t i = 0; i < width; i++) {
+        values[i] = from + i;
+        single += (uint64_t)primality_test(values[i]);
+    }
+    primality_test_batch(values, results, width);
+    for (uint64_t i = 0; i < width; i++) batched += results[i];
+    free(values);
+    free(results);
+    if (single != sieved || batched != sieved) {
+        printf("check: %llu primes singly and %llu batched near 10^12, the sieve finds %llu\n",
+               (unsigned long long)single, (unsigned long long)batched, (unsigned long long)sieved);
+        ok = 0;
+    }
+    return ok;
+}
+
+// GCD
+
+#define GCD_PAIRS 100000
+
+static uint64_t pairA[GCD_PAIRS], pairB[GCD_PAIRS];
+
+// GCD as Lab7.c had it: recursive Euclid through pointers
+static int euclidRecursive(int *num1, int *num2) {
+    if (*num2 == 0)
+        return *num1;
+    int temp = *num1 % *num2;
+    return euclidRecursive(num2, &temp);
+}
+
+static uint64_t euclid(uint64_t a, uint64_t b) {
+    while (b) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Random bits-bit pairs sharing a random factor of up to 16 bits
+static void fillPairs(int bits) {
+    uint64_t x = 0x9e3779b97f4a7c15ull ^ (uint64_t)bits;
+    uint64_t mask = bits == 64 ? ~0ull : ((uint64_t)1 << bits) - 1;
+    for (int i = 0; i < GCD_PAIRS; i++) {
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+        uint64_t f = (x >> 48) | 1;
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+        pairA[i] = ((x & mask) / f * f) | f;
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+        pairB[i] = ((x & mask) / f * f) | f;
+    }
+}
+
+static void benchEuclidRecursive(BenchState *st) {
+    fillPairs(31);
+    benchStart(st);
+    for (int i = 0; i < GCD_PAIRS; i++) {
+        int a = (int)pairA[i], b = (int)pairB[i];
+        sink += euclidRecursive(&a, &b);
+    }
+    benchStop(st);
+    st->items = GCD_PAIRS;
+}
+
+static void benchEuclid(BenchState *st) {
+    fillPairs((int)st->n);
+    benchStart(st);
+    for (int i = 0; i < GCD_PAIRS; i++) sink += (long)euclid(pairA[i], pairB[i]);
+    benchStop(st);
+    st->items = GCD_PAIRS;
+}
+
+static void benchBinaryGcd(BenchState *st) {
+    fillPairs((int)st->n);
+    benchStart(st);
+    for (int i = 0; i < GCD_PAIRS; i++) sink += (long)gcd_u64(pairA[i], pairB[i]);
+    benchStop(st);
+    st->items = GCD_PAIRS;
+}
+
+static void benchExtendedGcd(BenchState *st) {
+    fillPairs((int)st->n);
+    int64_t x, y;
+    benchStart(st);
+    for (int i = 0; i < GCD_PAIRS; i++) sink += (long)gcd_ext((int64_t)pairA[i], (int64_t)pairB[i], &x, &y);
+    benchStop(st);
+    st->items = GCD_PAIRS;
+}
+
+// Multiples of one large factor, so no chunk reaches 1 early
+static uint64_t *batchValues(size_t count) {
+    static uint64_t *values;
+    static size_t filled;
+    if (filled < count) {
+        free(values);
+        values = malloc(count * sizeof(uint64_t));
+        uint64_t x = 12345;
+        for (size_t i = 0; i < count; i++) {
+            x = x * 6364136223846793005ull + 1442695040888963407ull;
+            values[i] = 1000000007ull * ((x >> 40) + 1);
+        }
+        filled = count;
+    }
+    return values;
+}
+
+static void benchGcdBatch(BenchState *st) {
+    uint64_t *values = batchValues((size_t)st->n);
+    benchStart(st);
+    sink += (long)gcd_batch(values, (size_t)st->n, threadCount());
+    benchStop(st);
+    st->items = st->n;
+}
+
+static void benchGcdBig(BenchState *st) {
+    BigInt a, b, g;
+    bigint_init(&a);
+    bigint_init(&b);
+    bigint_init(&g);
+    fib_big(&a, (uint64_t)st->n);
+    fib_big(&b, (uint64_t)st->n * 3 / 2);
+    benchStart(st);
+    gcd_big(&g, &a, &b);
+    benchStop(st);
+    sink += (long)g.len;
+    bigint_free(&a);
+    bigint_free(&b);
+    bigint_free(&g);
+    st->items = 1;
+}
+
+static int checkGcd(void) {
+    int ok = 1;
+    for (int bits = 8; bits <= 64; bits += 8) {
+        fillPairs(bits);
+        for (int i = 0; i < GCD_PAIRS; i++) {
+            uint64_t a = pairA[i] >> (i % 5), b = i % 97 ? pairB[i] << (i % 3) : 0;
+            uint64_t g = gcd_u64(a, b);
+            int64_t x, y;
+            uint64_t e = gcd_ext((int64_t)a, -(int64_t)b, &x, &y);
+            __int128 bezout = (__int128)(int64_t)a * x + (__int128)(-(int64_t)b) * y;
+            if (g != euclid(a, b) || (a >> 63 == 0 && b >> 63 == 0 && (e != g || bezout != (__int128)g))) {
+                printf("check: gcd of %llu and %llu is wrong\n", (unsigned long long)a, (unsigned long long)b);
+                ok = 0;
+                break;
+            }
+        }
+    }
+    int a = -12, b = 18, min = INT_MIN, zero = 0;
+    uint64_t lcm;
+    if (GCD(&a, &b) != 6 || GCD(&min, &zero) != 2147483648u || GCD(&min, &min) != 2147483648u || !lcm_u64(1ull << 40, 3ull << 20, &lcm) || lcm != 3ull << 40 ||
+        lcm_u64(1ull << 40, 3ull << 24 | 1, &lcm)) {
+        printf("check: GCD/lcm_u64 edge cases are wrong\n");
+        ok = 0;
+    }
+
+    // batches against a sequential fold, across thread counts
+    uint64_t *values = batchValues(200000);
+    uint64_t g = 0;
+    for (size_t i = 0; i < 200000; i++) g = gcd_u64(g, values[i]);
+    uint64_t divisors[50000], l = 1;
+    for (size_t i = 0; i < 50000; i++) {
+        divisors[i] = (1ull << (i % 7)) * (i % 3 ? 3 : 1) * (i % 5 ? 1 : 25) * (i % 11 ? 1 : 7);
+        lcm_u64(l, divisors[i], &l);
+    }
+    for (int threads = 1; threads <= 8; threads *= 2) {
+        uint64_t batchLcm;
+        if (gcd_batch(values, 200000, threads) != g || !lcm_batch(divisors, 50000, threads, &batchLcm) ||
+            batchLcm != l) {
+            printf("check: batch GCD/LCM with %d threads is wrong\n", threads);
+            ok = 0;
+        }
+    }
+
+    // gcd(F(m), F(n)) = F(gcd(m, n))
+    BigInt fa, fb, fg, expect;
+    bigint_init(&fa);
+    bigint_init(&fb);
+    bigint_init(&fg);
+    bigint_init(&expect);
+    const uint64_t pairs[][2] = {{0, 5}, {12, 18}, {1000, 1500}, {2310, 4620}, {3001, 4500}};
+    for (size_t i = 0; i < sizeof(pairs) / sizeof(pairs[0]); i++) {
+        fib_big(&fa, pairs[i][0]);
+        fib_big(&fb, pairs[i][1]);
+        fib_big(&expect, gcd_u64(pairs[i][0], pairs[i][1]));
+        if (!gcd_big(&fg, &fa, &fb) || bigint_cmp(&fg, &expect) != 0) {
+            printf("check: gcd_big(F(%llu), F(%llu)) is wrong\n", (unsigned long long)pairs[i][0],
+                   (unsigned long long)pairs[i][1]);
+            ok = 0;
+        }
+    }
+    bigint_free(&fa);
+    bigint_free(&fb);
+    bigint_free(&fg);
+    bigint_free(&expect);
+    return ok;
+}
+
+static int checkFibonacci(void) {
+    int ok = 1;
+    FibStream s;
+    fib_stream_init(&s);
+    uint64_t term, value;
+    for (int i = 0; fib_stream_next(&s, &term); i++) {
+        if (!fib_u64((uint64_t)i, &value) || value != term || (i <= 30 && FIBO(&i) != (int)term)) {
+            printf("check: F(%d) differs between FIBO, the stream and fib_u64\n", i);
+            ok = 0;
+        }
+    }
+    if (fib_u64(FIB_U64_MAX_N + 1, &value)) {
+        printf("check: fib_u64 did not report overflow\n");
+        ok = 0;
+    }
+
+    FibBigStream big;
+    fib_big_stream_init(&big);
+    BigInt exact;
+    bigint_init(&exact);
+    for (uint64_t i = 0; i <= 3000; i++) {
+        const BigInt *t = fib_big_stream_next(&big);
+        if (i % 97 && i > 100) continue;
+        fib_big(&exact, i);
+        if (bigint_cmp(t, &exact) != 0) {
+            printf("check: fib_big(%llu) differs from the series\n", (unsigned long long)i);
+            ok = 0;
+        }
+        uint32_t mod = bigint_div_small(&exact, 1000000007);
+        if (fib_mod(i, 1000000007) != mod) {
+            printf("check: fib_mod(%llu) is wrong\n", (unsigned long long)i);
+            ok = 0;
+        }
+    }
+    fib_big_stream_free(&big);
+    bigint_free(&exact);
+    return ok;
+}
+
+// Checks the fast paths against the naive ones and FACT before timing
+static int checkResults(void) {
+    const long sizes[] = {0, 1, 2, 3, 7, 20, 21, 100, 257, 1000, 5000, 20000};
+    int ok = 1;
+    BigInt fast, slow;
+    bigint_init(&fast);
+    bigint_init(&slow);
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        long n = sizes[i];
+        bigint_factorial(&fast, (uint32_t)n);
+        naiveFactorial(&slow, n);
+        if (bigint_cmp(&fast, &slow) != 0) {
+            printf("check: bigint_factorial(%ld) is wrong\n", n);
+            ok = 0;
+        }
+        uint64_t value;
+        int in = (int)n;
+        if (n <= 20 && (!bigint_to_u64(&fast, &value) || (long)value != FACT(&in))) {
+            printf("check: FACT(%ld) disagrees with bigint_factorial\n", n);
+            ok = 0;
+        }
+        for (long k = 0; k <= n; k += n / 7 + 1) {
+            bigint_binomial(&fast, (uint32_t)n, (uint32_t)k);
+            naiveBinomial(&slow, n, k);
+            if (bigint_cmp(&fast, &slow) != 0) {
+                printf("check: bigint_binomial(%ld, %ld) is wrong\n", n, k);
+                ok = 0;
+            }
+        }
+    }
+    bigint_free(&fast);
+    bigint_free(&slow);
+    return checkFibonacci() && checkSieve() && checkPrimality() && checkGcd() && ok;
+}
+
+static const Benchmark benchmarks[] = {
+    {"factorial/FACT", benchFactRecursive, {20, 0}},
+    {"factorial/FACT_NONREC", benchFactLoop, {20, 0}},
+    {"factorial/naive", benchFactorialNaive, {1000, 10000, 100000, 0}},
+    {"factorial/swing", benchFactorialSwing, {20, 1000, 10000, 100000, 1000000, 0}},
+    {"binomial/naive", benchBinomialNaive, {1000, 10000, 100000, 0}},
+    {"binomial/prime", benchBinomialPrime, {1000, 10000, 100000, 1000000, 0}},
+    {"fibonacci/FIBO-series", benchFiboSeries, {20, 30, 35, 0}},
+    {"fibonacci/stream", benchFibStream, {35, 90, 0}},
+    {"fibonacci/big-stream", benchFibBigStream, {1000, 10000, 100000, 0}},
+    {"fibonacci/doubling", benchFibDoubling, {1000, 100000, 1000000, 10000000, 0}},
+    {"fibonacci/mod", benchFibMod, {1000000, 0}},
+    {"primes/ISPRIME", benchIsPrimeRange, {10000, 100000, 0}},
+    {"primes/sieve-count", benchSieveCount, {100000, 1000000, 100000000, 1000000000, 10000000000, 0}},
+    {"primes/sieve-list", benchSieveList, {1000000, 100000000, 1000000000, 0}},
+    {"primality/trial-division", benchTrialDivision, {20, 32, 40, 0}},
+    {"primality/miller-rabin", benchMillerRabin, {20, 32, 40, 64, 0}},
+    {"primality/batch", benchPrimalityBatch, {20, 32, 40, 64, 0}},
+    {"gcd/GCD-recursive", benchEuclidRecursive, {31, 0}},
+    {"gcd/euclid", benchEuclid, {32, 64, 0}},
+    {"gcd/binary", benchBinaryGcd, {32, 64, 0}},
+    {"gcd/extended", benchExtendedGcd, {32, 63, 0}},
+    {"gcd/batch", benchGcdBatch, {1000000, 10000000, 0}},
+    {"gcd/bigint", benchGcdBig, {1000, 10000, 30000, 0}},
+};
+
+int main(int argc, char *argv[]) {
+    const char *filter = argc > 1 ? argv[1] : NULL;
+    if (!checkResults()) return 1;
+
+    benchRunAll(benchmarks, sizeof(benchmarks) / sizeof(benchmarks[0]), filter);
+    return 0;
+}
@@ -0,0 +1,260 @@
+#include "primality.h"
+
+// Odd primes below 100 with p^-1 mod 2^64 and (2^64 - 1) / p: n is a
+// multiple of p exactly when n * p^-1 mod 2^64 <= (2^64 - 1) / p.
+static const struct {
+    uint32_t p;
+    uint64_t inverse, limit;
+} smallPrimes[] = {
+    {3u, 0xaaaaaaaaaaaaaaabull, 0x5555555555555555ull},
+    {5u, 0xcccccccccccccccdull, 0x3333333333333333ull},
+    {7u, 0x6db6db6db6db6db7ull, 0x2492492492492492ull},
+    {11u, 0x2e8ba2e8ba2e8ba3ull, 0x1745d1745d1745d1ull},
+    {13u, 0x4ec4ec4ec4ec4ec5ull, 0x13b13b13b13b13b1ull},
+    {17u, 0xf0f0f0f0f0f0f0f1ull, 0x0f0f0f0f0f0f0f0full},
+    {19u, 0x86bca1af286bca1bull, 0x0d79435e50d79435ull},
+    {23u, 0xd37a6f4de9bd37a7ull, 0x0b21642c8590b216ull},
+    {29u, 0x34f72c234f72c235ull, 0x08d3dcb08d3dcb08ull},
+    {31u, 0xef7bdef7bdef7bdfull, 0x0842108421084210ull},
+    {37u, 0x14c1bacf914c1badull, 0x06eb3e45306eb3e4ull},
+    {41u, 0x8f9c18f9c18f9c19ull, 0x063e7063e7063e70ull},
+    {43u, 0x82fa0be82fa0be83ull, 0x05f417d05f417d05ull},
+    {47u, 0x51b3bea3677d46cfull, 0x0572620ae4c415c9ull},
+    {53u, 0x21cfb2b78c13521dull, 0x04d4873ecade304dull},
+    {59u, 0xcbeea4e1a08ad8f3ull, 0x0456c797dd49c341ull},
+    {61u, 0x4fbcda3ac10c9715ull, 0x04325c53ef368eb0ull},
+    {67u, 0xf0b7672a07a44c6bull, 0x03d226357e16ece5ull},
+    {71u, 0x193d4bb7e327a977ull, 0x039b0ad12073615aull},
+    {73u, 0x7e3f1f8fc7e3f1f9ull, 0x0381c0e070381c0eull},
+    {79u, 0x9b8b577e613716afull, 0x033d91d2a2067b23ull},
+    {83u, 0xa3784a062b2e43dbull, 0x03159721ed7e7534ull},
+    {89u, 0xf47e8fd1fa3f47e9ull, 0x02e05c0b81702e05ull},
+    {97u, 0xa3a0fd5c5f02a3a1ull, 0x02a3a0fd5c5f02a3ull},
+};
+#define SMALL_PRIME_COUNT (sizeof(smallPrimes) / sizeof(smallPrimes[0]))
+
+// Every composite below 101^2 has a factor in smallPrimes or is even
+#define SCREEN_LIMIT (101u * 101u)
+
+// Bases making Miller-Rabin exact below 4759123141 and below 2^64
+static const uint64_t bases32[] = {2, 7, 61};
+static const uint64_t bases64[] = {2, 325, 9375, 28178, 450775, 9780504, 1795265022};
+#define BASES32_LIMIT 4759123141ull
+
+enum { COMPOSITE, PRIME, UNKNOWN };
+
+static int screen(uint64_t n) {
+    if (n < 2)
+        return COMPOSITE;
+    if ((n & 1) == 0)
+        return n == 2 ? PRIME : COMPOSITE;
+    for (size_t k = 0; k < SMALL_PRIME_COUNT; k++) {
+        if (n * smallPrimes[k].inverse <= smallPrimes[k].limit)
+            return n == smallPrimes[k].p ? PRIME : COMPOSITE;
+    }
+    return n < SCREEN_LIMIT ? PRIME : UNKNOWN;
+}
+
+// MONTGOMERY ARITHMETIC
+// Residues mod an odd n are kept as a * 2^64 mod n, so products reduce with
+// two multiplications and no division.
+
+typedef struct {
+    uint64_t n;
+    uint64_t inverse;   // n^-1 mod 2^64
+    uint64_t one;       // 2^64 mod n, i.e. 1
+    uint64_t r2;        // 2^128 mod n, for converting into the form
+} Mont;
+
+static void mont_init(Mont *m, uint64_t n) {
+    // n * n == 1 mod 8, and each Newton step doubles the correct bits
+    uint64_t inverse = n;
+    for (int i = 0; i < 5; i++)
+        inverse *= 2 - n * inverse;
+    m->n = n;
+    m->inverse = inverse;
+    m->one = (0 - n) % n;
+    m->r2 = (uint64_t)((__uint128_t)m->one * m->one % n);
+}
+
+// a * b / 2^64 mod n. q makes q * n agree with a * b in the low word, so the
+// difference of the high words is exact and lies in (-n, n).
+static inline uint64_t mont_mul(const Mont *m, uint64_t a, uint64_t b) {
+    __uint128_t t = (__uint128_t)a * b;
+    uint64_t q = (uint64_t)t * m->inverse;
+    uint64_t qn = (uint64_t)(((__uint128_t)q * m->n) >> 64);
+    uint64_t hi = (uint64_t)(t >> 64);
+    return hi >= qn ? hi - qn : hi - qn + m->n;
+}
+
+static void select_bases(uint64_t n, const uint64_t **bases, size_t *count) {
+    if (n < BASES32_LIMIT) {
+        *bases = bases32;
+        *count = sizeof(bases32) / sizeof(bases32[0]);
+    } else {
+        *bases = bases64;
+        *count = sizeof(bases64) / sizeof(bases64[0]);
+    }
+}
+
+// MILLER-RABIN
+// n - 1 = d * 2^s with d odd; n passes base a if a^d == 1 or a^(d 2^i) == -1
+// for some i < s. A base that is a multiple of n says nothing and is
+// skipped.
+
+static int miller_rabin(uint64_t n) {
+    Mont m;
+    mont_init(&m, n);
+    uint64_t d = n - 1;
+    int s = __builtin_ctzll(d);
+    d >>= s;
+    uint64_t minusOne = n - m.one;
+    const uint64_t *bases;
+    size_t count;
+    select_bases(n, &bases, &count);
+
+    for (size_t b = 0; b < count; b++) {
+        uint64_t a = bases[b] % n;
+        if (a == 0)
+            continue;
+        a = mont_mul(&m, a, m.r2);
+        uint64_t x = a;
+        for (int bit = 62 - __builtin_clzll(d); bit >= 0; bit--) {
+            x = mont_mul(&m, x, x);
+            if ((d >> bit) & 1)
+                x = mont_mul(&m, x, a);
+        }
+        if (x == m.one || x == minusOne)
+            continue;
+        int i = 1;
+        for (; i < s; i++) {
+            x = mont_mul(&m, x, x);
+            if (x == minusOne)
+                break;
+        }
+        if (i == s)
+            return 0;
+    }
+    return 1;
+}
+
+// The same test on PRIMALITY_LANES candidates at once, for bases
+// [first, last) of each lane's set. Lanes run as many squarings as the
+// longest d needs; a lane with a shorter d starts from 1, which squares to
+// itself. passed[l] is cleared when lane l fails a base.
+static void miller_rabin_lanes(const uint64_t *n, unsigned char *passed, size_t first, size_t last) {
+    Mont m[PRIMALITY_LANES];
+    uint64_t d[PRIMALITY_LANES], minusOne[PRIMALITY_LANES];
+    const uint64_t *bases[PRIMALITY_LANES];
+    size_t count[PRIMALITY_LANES], maxCount = 0;
+    int s[PRIMALITY_LANES];
+    int topBit = 0, maxS = 0;
+    for (int l = 0; l < PRIMALITY_LANES; l++) {
+        mont_init(&m[l], n[l]);
+        s[l] = __builtin_ctzll(n[l] - 1);
+        d[l] = (n[l] - 1) >> s[l];
+        minusOne[l] = n[l] - m[l].one;
+        select_bases(n[l], &bases[l], &count[l]);
+        passed[l] = 1;
+        int top = 63 - __builtin_clzll(d[l]);
+        topBit = top > topBit ? top : topBit;
+        maxS = s[l] > maxS ? s[l] : maxS;
+        maxCount = count[l] > maxCount ? count[l] : maxCount;
+    }
+
+    for (size_t b = first; b < last && b < maxCount; b++) {
+        uint64_t a[PRIMALITY_LANES], x[PRIMALITY_LANES];
+        int pending = 0;
+        for (int l = 0; l < PRIMALITY_LANES; l++) {
+            uint64_t base = b < count[l] ? bases[l][b] % n[l] : 0;
+            a[l] = mont_mul(&m[l], base, m[l].r2);
+            x[l] = m[l].one;
+            pending |= passed[l] && base != 0;
+        }
+        if (!pending)
+            continue;
+        for (int bit = topBit; bit >= 0; bit--) {
+            for (int l = 0; l < PRIMALITY_LANES; l++) {
+                x[l] = mont_mul(&m[l], x[l], x[l]);
+                if ((d[l] >> bit) & 1)
+                    x[l] = mont_mul(&m[l], x[l], a[l]);
+            }
+        }
+        unsigned char ok[PRIMALITY_LANES];
+        for (int l = 0; l < PRIMALITY_LANES; l++)
+            ok[l] = a[l] == 0 || x[l] == m[l].one || x[l] == minusOne[l];
+        for (int i = 1; i < maxS; i++) {
+            for (int l = 0; l < PRIMALITY_LANES; l++) {
+                if (ok[l] || i >= s[l])
+                    continue;
+                x[l] = mont_mul(&m[l], x[l], x[l]);
+                ok[l] = x[l] == minusOne[l];
+            }
+        }
+        for (int l = 0; l < PRIMALITY_LANES; l++)
+            passed[l] &= ok[l];
+    }
+}
+
+// Runs bases [first, last) on the values still UNKNOWN, PRIMALITY_LANES at
+// a time; a partial group is padded with copies of its first value. Values
+// that fail become COMPOSITE, and values that have now passed their whole
+// base set become PRIME.
+static void lanes_pass(const uint64_t *values, unsigned char *results, size_t count,
+                       size_t first, size_t last) {
+    size_t lane[PRIMALITY_LANES];
+    uint64_t n[PRIMALITY_LANES];
+    unsigned char passed[PRIMALITY_LANES];
+    int used = 0;
+    for (size_t i = 0; i <= count; i++) {
+        if (i < count) {
+            if (results[i] != UNKNOWN)
+                continue;
+            lane[used] = i;
+            n[used++] = values[i];
+            if (used < PRIMALITY_LANES)
+                continue;
+        } else if (used == 0) {
+            break;
+        }
+        for (int l = used; l < PRIMALITY_LANES; l++)
+            n[l] = n[0];
+        miller_rabin_lanes(n, passed, first, last);
+        for (int l = 0; l < used; l++) {
+            const uint64_t *bases;
+            size_t total;
+            select_bases(n[l], &bases, &total);
+            if (!passed[l])
+                results[lane[l]] = COMPOSITE;
+            else if (last >= total)
+                results[lane[l]] = PRIME;
+        }
+        used = 0;
+    }
+}
+
+int primality_test(uint64_t n) {
+    int r = screen(n);
+    return r == UNKNOWN ? miller_rabin(n) : r == PRIME;
+}
+
+void primality_test_batch(const uint64_t *values, unsigned char *results, size_t count) {
+    // Screen every value against every small prime without early exits
+    for (size_t i = 0; i < count; i++) {
+        uint64_t n = values[i];
+        unsigned divisible = (n & 1) == 0;
+        for (size_t k = 0; k < SMALL_PRIME_COUNT; k++)
+            divisible |= n * smallPrimes[k].inverse <= smallPrimes[k].limit;
+        results[i] = divisible ? COMPOSITE : UNKNOWN;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (values[i] < SCREEN_LIMIT)
+            results[i] = (unsigned char)screen(values[i]);
+    }
+
+    // Base 2 first rejects nearly every composite left, so only probable
+    // primes pay for the rest of the base set.
+    lanes_pass(values, results, count, 0, 1);
+    lanes_pass(values, results, count, 1, (size_t)-1);
+}
@@ -0,0 +1,20 @@
+#ifndef PRIMALITY_H
+#define PRIMALITY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Candidates the batch test runs Miller-Rabin on side by side
+#define PRIMALITY_LANES 4
+
+// 1 if n is prime, else 0. Multiples of the primes below 100 are screened
+// out first; what is left goes to Miller-Rabin in Montgomery form, with base
+// sets that are deterministic for every 64-bit n.
+int primality_test(uint64_t n);
+
+// results[i] = primality_test(values[i]). The screen runs as one branch-free
+// pass over the array and the survivors are tested PRIMALITY_LANES at a
+// time, so independent multiplications overlap.
+void primality_test_batch(const uint64_t *values, unsigned char *results, size_t count);
+
+#endif
@@ -1,128 +1,253 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <ctype.h>
 #include <time.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
 
-// ----- CONSTANTS -----
-#define MAX_NAME_LEN 50
-#define MAX_PROFILES 100
-#define MAX_LINE 256
-#define MAX_ROUNDS 20
-#define MAX_HISTORY 200
-#define MAX_MOVE_LEN 5
+#include "hrst.h"
 
-#define PROFILE_FILE "profiles.dat"
-#define HIGHSCORE_FILE "highscores.txt"
-#define STATS_FILE "gamestats.txt"
 
-// ----- STRUCTS -----
+// ----- MAIN FUNCTION -----
+// Build: make (build/hrst), or gcc hrst.c -o hrst -pthread
+// Compiled with -DHRST_NO_MAIN for the game core library (build/libhrst.a).
+#ifndef HRST_NO_MAIN
+// Options: --seed <n> replays a run exactly; --rng <xoshiro|pcg> picks the engine;
+// --opponent adaptive plays against the pattern-learning computer;
+// --sync-every <n> flushes data files to disk once per n games (1 = every game);
+// --replay <file> reads menu input from a recorded transcript instead of stdin;
+// --metrics <prometheus|json> prints probe timings and counters on exit;
+// --rules <file> loads moves and scoring (default: rules.cfg if it exists).
+int main(int argc, char *argv[]) {
+    uint64_t seed = defaultSeed();
+    RngEngine engine = RNG_XOSHIRO;
+    OpponentKind opponent = OPPONENT_RANDOM;
+    const char *rulesPath = NULL;
 
-typedef struct {
-    char name[MAX_NAME_LEN];
-    int gamesPlayed;
-    int wins;
-    int losses;
-} Profile;
+    // Output is flushed when the program waits for input, i.e. once per screen
+    setvbuf(stdout, NULL, _IOFBF, OUTPUT_BUFFER);
 
-typedef struct {
-    char playerName[MAX_NAME_LEN];
-    int roundsPlayed;
-    int wins;
-    int losses;
-    char movesHistory[MAX_HISTORY][MAX_MOVE_LEN];      // player moves
-    char compMovesHistory[MAX_HISTORY][MAX_MOVE_LEN];  // computer moves
-} GameSession;
-
-// ----- FUNCTION PROTOTYPES -----
-
-// Input and output
-int readLine(char *buffer, int length);
-int getIntInRange(const char *prompt, int min, int max);
-int confirmYesNo(const char *prompt);
-void toUpperStr(char *str);
-void pauseProgram();
-void printHeader(const char *title);
-void printFooter();
-void printDivider();
-void printEmptyLines(int count);
-
-// Profile management
-int loadProfiles(Profile profiles[], int maxProfiles);
-int saveProfiles(Profile profiles[], int count);
-int findProfileIndex(Profile profiles[], int count, const char *name);
-void addNewProfile(Profile profiles[], int *count);
-void renameProfile(Profile profiles[], int count);
-void deleteProfile(Profile profiles[], int *count);
-void showProfiles(Profile profiles[], int count);
-void viewProfileDetails(Profile *p);
-void updateProfileStats(Profile *p, GameSession *session);
-
-// Game logic
-void playGame(Profile profiles[], int profCount);
-int isValidBasicMove(const char *move);
-int isValidAdvancedMove(const char *move);
-int isValidMove(const char *move, int mode);
-const char *mapAdvancedMove(const char *input);
-const char *computerMove(int mode);
-void printRoundResult(const char *playerMove, const char *compMove, int *win, int *loss);
-
-// Scoreboard
-void saveScoreToFile(GameSession *session);
-void displayScoreboard();
-
-// Stats Logging
-void saveGameStats(GameSession *session, int mode);
-void viewGameStats();
-
-// Menu and interface
-void mainMenu(Profile profiles[], int *profCount);
-void profilesMenu(Profile profiles[], int *profCount);
-void gameMenu(Profile profiles[], int profCount);
-void scoreboardMenu();
-void statsMenu();
-void instructionsMenu();
-
-// Helper for long line printing and delays
-void waitSeconds(int seconds);
+    // Strip global options, keeping the remaining arguments in order
+    int argCount = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--rng") == 0 && i + 1 < argc) {
+            engine = strcmp(argv[++i], "pcg") == 0 ? RNG_PCG : RNG_XOSHIRO;
+        } else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+            if (!metricsSetFormat(argv[++i])) {
+                printf("Unknown metrics format '%s' (use prometheus or json).\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            if (!openReplay(argv[++i])) {
+                printf("Error: Could not open replay file %s.\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--sync-every") == 0 && i + 1 < argc) {
+            durableSetBatch(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--rules") == 0 && i + 1 < argc) {
+            rulesPath = argv[++i];
+        } else if (strcmp(argv[i], "--opponent") == 0 && i + 1 < argc) {
+            opponent = strcmp(argv[++i], "adaptive") == 0 ? OPPONENT_ADAPTIVE : OPPONENT_RANDOM;
+        } else {
+            argv[argCount++] = argv[i];
+        }
+    }
+    argc = argCount;
+    if (!loadRules(rulesPath)) return 1;
 
+    Rng rng;
+    rngSeed(&rng, engine, seed);
 
-// ----- MAIN FUNCTION -----
-int main() {
-    srand((unsigned int)time(NULL)); // Seed for random
+    if (argc > 1 && strcmp(argv[1], "--simulate") == 0) {
+        if (argc < 6) {
+            printf("Usage: %s [--seed n] [--rng xoshiro|pcg] [--opponent random|adaptive] --simulate <random|fixed|cycle> <basic|advanced> <rounds> <games> [threads]\n", argv[0]);
+            return 1;
+        }
+        int mode = strcmp(argv[3], "advanced") == 0 ? 2 : 1;
+        int threads = argc > 6 ? atoi(argv[6]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+        printf("Seed: %llu\n", (unsigned long long)seed);
+        return runSimulation(&rng, opponent, argv[2], mode, atoi(argv[4]), atol(argv[5]), threads) ? 0 : 1;
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-opponent") == 0) {
+        return benchmarkOpponent(&rng, argc > 2 ? atol(argv[2]) : 100000) ? 0 : 1;
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--analytics") == 0) {
+        return runAnalytics(argc > 2 ? argv[2] : NULL) ? 0 : 1;
+    }
+    if (argc > 1 && strcmp(argv[1], "--verify-log") == 0) {
+        return runVerifyLog(argc > 2 ? atoi(argv[2]) : (int)sysconf(_SC_NPROCESSORS_ONLN)) ? 0 : 1;
+    }
+    if (argc > 1 && strcmp(argv[1], "--show-session") == 0) {
+        if (argc < 3) {
+            printf("Usage: %s --show-session <session number>\n", argv[0]);
+            return 1;
+        }
+        return showSession(atol(argv[2])) ? 0 : 1;
+    }
+
+    ProfileStore store;
+    if (!loadProfiles(&store)) {
+        printf("Error: Could not open %s.\n", PROFILE_FILE);
+        return 1;
+    }
+
+    Leaderboard lb;
+    if (!openLeaderboard(&lb)) {
+        printf("Error: Could not open %s.\n", LEADERBOARD_FILE);
+        closeProfiles(&store);
+        return 1;
+    }
+    durableAttach(&store, &lb);
 
-    Profile profiles[MAX_PROFILES];
-    int profileCount = 0;
+    if (argc > 1 && strcmp(argv[1], "--tournament") == 0) {
+        int ok = 0;
+        char *end = NULL;
+        long bots = argc > 2 && strcmp(argv[2], "profiles") != 0 ? strtol(argv[2], &end, 10) : 0;
+        if (argc < 6) {
+            printf("Usage: %s [--seed n] [--rng xoshiro|pcg] --tournament <profiles|bot count> <round-robin|knockout> <basic|advanced> <rounds> [threads]\n", argv[0]);
+        } else if (end && (end == argv[2] || *end != '\0' || bots < 2 || bots > MAX_ENTRANTS)) {
+            // Anything but "profiles" must be a bot count, so a typo never
+            // turns into a profile tournament that writes the leaderboard
+            printf("Entrants must be 'profiles' or a bot count of 2-%d, not '%s'.\n", MAX_ENTRANTS, argv[2]);
+        } else {
+            BracketKind bracket = strcmp(argv[3], "knockout") == 0 ? BRACKET_KNOCKOUT : BRACKET_ROUND_ROBIN;
+            int mode = strcmp(argv[4], "advanced") == 0 ? 2 : 1;
+            int threads = argc > 6 ? atoi(argv[6]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+            printf("Seed: %llu\n", (unsigned long long)seed);
+            ok = runTournament(&store, &lb, &rng, (int)bots, bracket, mode, atoi(argv[5]), threads);
+        }
+        durableShutdown();
+        closeLeaderboard(&lb);
+        closeProfiles(&store);
+        return ok ? 0 : 1;
+    }
 
-    profileCount = loadProfiles(profiles, MAX_PROFILES);
+    if (argc > 1 && strcmp(argv[1], "--serve") == 0) {
+        int ok = runServer(argc > 2 ? argv[2] : "7777", &store, &lb, &rng, opponent);
+        durableShutdown();
+        closeLeaderboard(&lb);
+        closeProfiles(&store);
+        return ok ? 0 : 1;
+    }
 
     printHeader("Welcome to Cham Cham Cham!");
 
-    mainMenu(profiles, &profileCount);
+    mainMenu(&store, &lb, &rng, opponent);
 
+    durableShutdown();
+    closeLeaderboard(&lb);
+    closeProfiles(&store);
     return 0;
 }
+#endif // HRST_NO_MAIN
 
 
 // INPUT / OUTPUT HELPERS
+//
+// All menu input comes through inputLine, which reads stdin (or a replay
+// transcript) in INPUT_CHUNK blocks and hands out lines in place inside the
+// chunk buffer. stdout is fully buffered and only flushed right before a
+// read that may block, so a scripted run writes its output in large blocks.
 
-int readLine(char *buffer, int length) {
-    if (fgets(buffer, length, stdin)) {
-        buffer[strcspn(buffer, "\n")] = '\0'; // strip newline
-        return 1;
+static struct {
+    int fd;
+    char buf[INPUT_CHUNK + 1];  // +1 so the final line can always be terminated
+    size_t len;
+    size_t pos;
+} input = {STDIN_FILENO, {0}, 0, 0};
+
+int openReplay(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    input.fd = fd;
+    input.len = input.pos = 0;
+    return 1;
+}
+
+// Returns the next line with its newline (and any \r) removed, NUL-terminated
+// in place. It stays valid until the next call. Returns NULL at end of input.
+char *inputLine(void) {
+    while (1) {
+        char *start = input.buf + input.pos;
+        char *nl = memchr(start, '\n', input.len - input.pos);
+        if (nl) {
+            *nl = '\0';
+            if (nl > start && nl[-1] == '\r') nl[-1] = '\0';
+            input.pos = (size_t)(nl - input.buf) + 1;
+            METRIC_ADD(COUNTER_INPUT_LINES, 1);
+            return start;
+        }
+
+        // Keep the partial line at the front and read more after it
+        size_t partial = input.len - input.pos;
+        memmove(input.buf, start, partial);
+        input.pos = 0;
+        input.len = partial;
+        if (partial == INPUT_CHUNK) { // over-long line: hand back what fits
+            input.buf[INPUT_CHUNK] = '\0';
+            input.len = 0;
+            return input.buf;
+        }
+
+        fflush(stdout);
+        METRIC_TIMER_START(waitStart);
+        ssize_t n = read(input.fd, input.buf + input.len, INPUT_CHUNK - input.len);
+        METRIC_TIMER_STOP(waitStart, TIMER_INPUT_WAIT);
+        METRIC_ADD(COUNTER_INPUT_READS, 1);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            if (input.len == 0) return NULL;
+            input.buf[input.len] = '\0'; // last line had no newline
+            input.pos = input.len;
+            return input.buf;
+        }
+        input.len += (size_t)n;
     }
-    return 0;
+}
+
+// Input ran out (end of a replay or closed stdin): save and leave cleanly
+// instead of re-prompting forever.
+void endOfInput(void) {
+    printf("\nEnd of input.\n");
+    durableShutdown();
+    exit(0);
+}
+
+int readLine(char *buffer, int length) {
+    char *line = inputLine();
+    if (!line) endOfInput();
+    strncpy(buffer, line, (size_t)length - 1);
+    buffer[length - 1] = '\0';
+    return 1;
 }
 
 int getIntInRange(const char *prompt, int min, int max) {
-    char line[MAX_LINE];
     int value;
     while (1) {
         printf("%s", prompt);
-        if (!readLine(line, MAX_LINE)) {
-            printf("Error reading input, please try again.\n");
-            continue;
-        }
+        char *line = inputLine();
+        if (!line) endOfInput();
         if (sscanf(line, "%d", &value) != 1) {
             printf("Invalid number, please enter a valid integer.\n");
             continue;
@@ -136,11 +261,11 @@ int getIntInRange(const char *prompt, int min, int max) {
 }
 
 int confirmYesNo(const char *prompt) {
-    char line[MAX_LINE];
     while (1) {
         printf("%s (y/n): ", prompt);
-        if (!readLine(line, MAX_LINE)) continue;
-        if (strlen(line) == 0) continue;
+        char *line = inputLine();
+        if (!line) endOfInput();
+        if (line[0] == '\0') continue;
         char c = (char)tolower(line[0]);
         if (c == 'y') return 1;
         if (c == 'n') return 0;
@@ -156,9 +281,7 @@ void toUpperStr(char *str) {
 
 void pauseProgram() {
     printf("Press Enter to continue...");
-    fflush(stdout);
-    char temp[16];
-    fgets(temp, sizeof(temp), stdin);
+    if (!inputLine()) endOfInput();
 }
 
 void printHeader(const char *title) {
@@ -172,7 +295,7 @@ void printFooter() {
 }
 
 void printDivider() {
-    printf("----------------------------------------\n");
+    printf("%s", DIVIDER);
 }
 
 void printEmptyLines(int count) {
@@ -182,485 +305,4000 @@ void printEmptyLines(int count) {
 }
 
 
-// PROFILE MANAGEMENT
+// METRICS
+//
+// hrst --metrics <prometheus|json> prints every probe to stderr on exit.
+// Probes only record anything in builds with -DHRST_METRICS (make METRICS=1).
+// Updates are relaxed atomics, so probes are safe from any thread.
 
-int loadProfiles(Profile profiles[], int maxProfiles) {
-    FILE *fp = fopen(PROFILE_FILE, "rb");
-    if (!fp) return 0; // no file yet
+static const char *timerNames[TIMER_COUNT] = {
+    "input_wait", "profile_load", "profile_save", "score_save", "leaderboard_catch_up",
+    "scoreboard_render", "stats_save", "game_record", "durable_sync", "analytics_refresh",
+    "lock_wait"
+};
 
-    int count = 0;
-    while (count < maxProfiles && fread(&profiles[count], sizeof(Profile), 1, fp) == 1) {
-        count++;
-    }
-    fclose(fp);
-    return count;
+static const char *counterNames[COUNTER_COUNT] = {
+    "input_lines", "input_reads", "bytes_appended", "fsyncs", "score_lines_folded",
+    "log_records_folded", "games_recorded"
+};
+
+static struct {
+    TimerMetric timers[TIMER_COUNT];
+    uint64_t counters[COUNTER_COUNT];
+    int format;     // 0 = off, 1 = Prometheus, 2 = JSON
+} metrics;
+
+uint64_t metricNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
 }
 
-int saveProfiles(Profile profiles[], int count) {
-    FILE *fp = fopen(PROFILE_FILE, "wb");
-    if (!fp) {
-        printf("Error: Could not save profiles.\n");
+void metricObserve(MetricTimer timer, uint64_t ns) {
+    TimerMetric *m = &metrics.timers[timer];
+    int bucket = ns ? 63 - __builtin_clzll(ns) : 0;
+    if (bucket >= METRIC_BUCKETS) bucket = METRIC_BUCKETS - 1;
+    __atomic_fetch_add(&m->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m->sumNs, ns, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m->buckets[bucket], 1, __ATOMIC_RELAXED);
+}
+
+void metricAdd(MetricCounter counter, uint64_t n) {
+    __atomic_fetch_add(&metrics.counters[counter], n, __ATOMIC_RELAXED);
+}
+
+// Selects the dump format and registers the dump to run at exit.
+int metricsSetFormat(const char *format) {
+    if (strcmp(format, "prometheus") == 0) {
+        metrics.format = 1;
+    } else if (strcmp(format, "json") == 0) {
+        metrics.format = 2;
+    } else {
         return 0;
     }
-    fwrite(profiles, sizeof(Profile), count, fp);
-    fclose(fp);
+    atexit(metricsDump);
     return 1;
 }
 
-int findProfileIndex(Profile profiles[], int count, const char *name) {
-    for (int i = 0; i < count; i++) {
-        if (strcmp(profiles[i].name, name) == 0) {
-            return i;
+static void dumpPrometheus(FILE *out) {
+    for (int t = 0; t < TIMER_COUNT; t++) {
+        const TimerMetric *m = &metrics.timers[t];
+        fprintf(out, "# TYPE hrst_%s_seconds histogram\n", timerNames[t]);
+        uint64_t cumulative = 0;
+        for (int b = 0; b < METRIC_BUCKETS - 1 && cumulative < m->count; b++) {
+            cumulative += m->buckets[b];
+            fprintf(out, "hrst_%s_seconds_bucket{le=\"%.9g\"} %llu\n", timerNames[t],
+                    (double)(2ull << b) / 1e9, (unsigned long long)cumulative);
         }
+        fprintf(out, "hrst_%s_seconds_bucket{le=\"+Inf\"} %llu\n", timerNames[t], (unsigned long long)m->count);
+        fprintf(out, "hrst_%s_seconds_sum %.9f\n", timerNames[t], (double)m->sumNs / 1e9);
+        fprintf(out, "hrst_%s_seconds_count %llu\n", timerNames[t], (unsigned long long)m->count);
+    }
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        fprintf(out, "# TYPE hrst_%s_total counter\n", counterNames[c]);
+        fprintf(out, "hrst_%s_total %llu\n", counterNames[c], (unsigned long long)metrics.counters[c]);
     }
-    return -1;
 }
 
-void addNewProfile(Profile profiles[], int *count) {
-    if (*count >= MAX_PROFILES) {
-        printf("Profile limit reached, cannot add more.\n");
-        pauseProgram();
-        return;
-    }
-    char name[MAX_NAME_LEN];
-    printf("Enter new player name: ");
-    if (!readLine(name, MAX_NAME_LEN)) {
-        printf("Input error.\n");
-        pauseProgram();
-        return;
-    }
-    if (strlen(name) == 0) {
-        printf("Name cannot be empty.\n");
-        pauseProgram();
-        return;
+static void dumpJson(FILE *out) {
+    fprintf(out, "{\"timers\": {");
+    for (int t = 0; t < TIMER_COUNT; t++) {
+        const TimerMetric *m = &metrics.timers[t];
+        fprintf(out, "%s\n  \"%s\": {\"count\": %llu, \"sum_ns\": %llu, \"buckets\": [", t ? "," : "",
+                timerNames[t], (unsigned long long)m->count, (unsigned long long)m->sumNs);
+        int first = 1;
+        for (int b = 0; b < METRIC_BUCKETS; b++) {
+            if (!m->buckets[b]) continue;
+            fprintf(out, "%s[%llu, %llu]", first ? "" : ", ", 2ull << b, (unsigned long long)m->buckets[b]);
+            first = 0;
+        }
+        fprintf(out, "]}");
     }
-    if (findProfileIndex(profiles, *count, name) != -1) {
-        printf("Profile with this name already exists.\n");
-        pauseProgram();
-        return;
+    fprintf(out, "\n}, \"counters\": {");
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        fprintf(out, "%s\n  \"%s\": %llu", c ? "," : "", counterNames[c], (unsigned long long)metrics.counters[c]);
     }
-    Profile newProfile = {0};
-    strncpy(newProfile.name, name, MAX_NAME_LEN - 1);
-    newProfile.gamesPlayed = 0;
-    newProfile.wins = 0;
-    newProfile.losses = 0;
-
-    profiles[*count] = newProfile;
-    (*count)++;
+    fprintf(out, "\n}}\n");
+}
 
-    if (!saveProfiles(profiles, *count)) {
-        printf("Failed to save profiles.\n");
+// JSON buckets are [upper bound in ns, count] pairs for the non-empty ones.
+void metricsDump(void) {
+    if (!metrics.format) return;
+#ifndef HRST_METRICS
+    fprintf(stderr, "Note: built without HRST_METRICS, so no probes were recorded.\n");
+#endif
+    if (metrics.format == 1) {
+        dumpPrometheus(stderr);
     } else {
-        printf("Profile '%s' added successfully.\n", name);
+        dumpJson(stderr);
     }
-    pauseProgram();
 }
 
-void renameProfile(Profile profiles[], int count) {
-    if (count == 0) {
-        printf("No profiles available.\n");
-        pauseProgram();
-        return;
+// MEMORY-MAPPED FILES
+
+// Maps the whole file. The old mapping is only dropped once the new one is
+// in place, so on failure the caller still holds a valid, smaller view.
+static int mapRemap(MappedFile *mf) {
+    struct stat st;
+    if (fstat(mf->fd, &st) != 0) return 0;
+    void *base = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, mf->fd, 0);
+    if (base == MAP_FAILED) return 0;
+    if (mf->base) munmap(mf->base, mf->mapSize);
+    mf->base = base;
+    mf->mapSize = (size_t)st.st_size;
+    mf->header = (FileHeader *)mf->base;
+    return 1;
+}
+
+// Opens (creating if needed) a mapped file and validates its header. Files
+// written with another byte order, a newer version or a different record
+// layout are refused rather than misread.
+int mapOpen(MappedFile *mf, const char *path, const char *magic, uint32_t version, uint32_t recordSize) {
+    memset(mf, 0, sizeof(*mf));
+    mf->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (mf->fd < 0) return 0;
+
+    struct stat st;
+    if (fstat(mf->fd, &st) != 0) {
+        mapClose(mf);
+        return 0;
     }
-    showProfiles(profiles, count);
-    int choice = getIntInRange("Select profile number to rename: ", 1, count);
-    int idx = choice - 1;
-    printf("Current name: %s\n", profiles[idx].name);
-    printf("Enter new name: ");
-    char newName[MAX_NAME_LEN];
-    if (!readLine(newName, MAX_NAME_LEN)) {
-        printf("Input error.\n");
-        pauseProgram();
-        return;
+    if (st.st_size == 0) {
+        FileHeader h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, magic, 4);
+        h.version = version;
+        h.byteOrder = BYTE_ORDER_MARK;
+        h.recordSize = recordSize;
+        if (write(mf->fd, &h, sizeof(h)) != (ssize_t)sizeof(h)) {
+            mapClose(mf);
+            return 0;
+        }
+    } else if ((size_t)st.st_size < sizeof(FileHeader)) {
+        mapClose(mf);
+        return 0;
     }
-    if (strlen(newName) == 0) {
-        printf("Name cannot be empty.\n");
-        pauseProgram();
-        return;
+    if (!mapRemap(mf)) {
+        mapClose(mf);
+        return 0;
     }
-    if (findProfileIndex(profiles, count, newName) != -1) {
-        printf("Another profile with this name exists.\n");
-        pauseProgram();
-        return;
+
+    FileHeader *h = mf->header;
+    if (memcmp(h->magic, magic, 4) != 0 || h->byteOrder != BYTE_ORDER_MARK ||
+        h->version > version || h->recordSize != recordSize ||
+        mf->mapSize < sizeof(FileHeader) + (size_t)h->capacity * recordSize ||
+        h->count > h->capacity) {
+        mapClose(mf);
+        return 0;
     }
-    strncpy(profiles[idx].name, newName, MAX_NAME_LEN - 1);
+    return 1;
+}
 
-    if (!saveProfiles(profiles, count)) {
-        printf("Failed to save profiles.\n");
-    } else {
-        printf("Profile renamed successfully.\n");
+// Grows the file so it can hold at least `capacity` records. On failure the
+// mapping and the capacity in the header are left as they were.
+int mapReserve(MappedFile *mf, uint32_t capacity) {
+    if (!mf->base) return 0;
+    if (capacity <= mf->header->capacity) return 1;
+    uint32_t newCapacity = mf->header->capacity ? mf->header->capacity : INITIAL_RECORD_CAPACITY;
+    while (newCapacity < capacity) newCapacity *= 2;
+    off_t size = (off_t)sizeof(FileHeader) + (off_t)newCapacity * mf->header->recordSize;
+    if (ftruncate(mf->fd, size) != 0 || !mapRemap(mf)) return 0;
+    mf->header->capacity = newCapacity;
+    return 1;
+}
+
+// Remaps the file if another process has grown it. Files never shrink, so
+// a mapping that still covers the capacity in the shared header is current.
+int mapRefresh(MappedFile *mf) {
+    if (!mf->base) return 0;
+    FileHeader *h = mf->header;
+    if (sizeof(FileHeader) + (size_t)h->capacity * h->recordSize <= mf->mapSize) return 1;
+    return mapRemap(mf);
+}
+
+void *mapRecords(MappedFile *mf) {
+    return (char *)mf->base + sizeof(FileHeader);
+}
+
+void mapClose(MappedFile *mf) {
+    if (mf->base) munmap(mf->base, mf->mapSize);
+    if (mf->fd >= 0) close(mf->fd);
+    memset(mf, 0, sizeof(*mf));
+    mf->fd = -1;
+}
+
+// NAME INDEX
+
+// FNV-1a over a name
+static uint32_t hashName(const char *name) {
+    uint32_t h = 2166136261u;
+    for (; *name; name++) {
+        h ^= (unsigned char)*name;
+        h *= 16777619u;
     }
-    pauseProgram();
+    return h;
 }
 
-void deleteProfile(Profile profiles[], int *count) {
-    if (*count == 0) {
-        printf("No profiles to delete.\n");
-        pauseProgram();
-        return;
+static const char *indexedName(NameIndex *ix, int record) {
+    return ix->base + (size_t)record * ix->stride;
+}
+
+// Returns the slot holding name, or the empty slot where it would go.
+static int indexSlot(NameIndex *ix, const char *name) {
+    int mask = ix->size - 1;
+    int slot = (int)(hashName(name) & (uint32_t)mask);
+    while (ix->slots[slot] != -1 && strcmp(indexedName(ix, ix->slots[slot]), name) != 0) {
+        slot = (slot + 1) & mask;
     }
-    showProfiles(profiles, *count);
-    int choice = getIntInRange("Select profile number to delete: ", 1, *count);
-    int idx = choice - 1;
-    printf("Are you sure you want to delete '%s'? This cannot be undone.\n", profiles[idx].name);
-    if (confirmYesNo("Confirm deletion")) {
-        // Shift profiles down
-        for (int i = idx; i < (*count) - 1; i++) {
-            profiles[i] = profiles[i + 1];
+    return slot;
+}
+
+static int rebuildIndex(NameIndex *ix, int count, int size) {
+    int *slots = malloc(sizeof(int) * size);
+    if (!slots) return 0;
+    for (int i = 0; i < size; i++) slots[i] = -1;
+    free(ix->slots);
+    ix->slots = slots;
+    ix->size = size;
+    for (int i = 0; i < count; i++) {
+        ix->slots[indexSlot(ix, indexedName(ix, i))] = i;
+    }
+    return 1;
+}
+
+// Builds the index on first use and keeps it at most half full, so opening
+// a store does no per-record work.
+static int ensureIndex(NameIndex *ix, int count, int needed) {
+    if (needed * 2 <= ix->size) return 1;
+    int size = ix->size ? ix->size : INITIAL_RECORD_CAPACITY * 2;
+    while (needed * 2 > size) size *= 2;
+    return rebuildIndex(ix, count, size);
+}
+
+// Linear-probing removal with backward shift, so lookups never need tombstones.
+// The records referenced by the index must still hold their names.
+static void indexErase(NameIndex *ix, int slot) {
+    int mask = ix->size - 1;
+    int hole = slot;
+    int i = slot;
+    while (1) {
+        i = (i + 1) & mask;
+        if (ix->slots[i] == -1) break;
+        int home = (int)(hashName(indexedName(ix, ix->slots[i])) & (uint32_t)mask);
+        // Keep the entry where it is if its home lies cyclically in (hole, i]
+        int stays = (hole <= i) ? (home > hole && home <= i) : (home > hole || home <= i);
+        if (!stays) {
+            ix->slots[hole] = ix->slots[i];
+            hole = i;
         }
-        (*count)--;
-        if (!saveProfiles(profiles, *count)) {
-            printf("Failed to save profiles.\n");
-        } else {
-            printf("Profile deleted.\n");
+    }
+    ix->slots[hole] = -1;
+}
+
+// Files records [from, to) that another process appended to a shared store.
+// An index not built yet is left alone; it will see them when it is.
+static int indexAppend(NameIndex *ix, int from, int to) {
+    if (ix->size == 0) return 1;
+    if (!ensureIndex(ix, from, to + 1)) return 0;
+    for (int i = from; i < to; i++) ix->slots[indexSlot(ix, indexedName(ix, i))] = i;
+    return 1;
+}
+
+// PROCESS LOCKS
+//
+// Any number of hrst processes can share one data directory. Each shared
+// resource is one byte of hrst.lock, locked with fcntl: shared to read,
+// exclusive to change. A lock is held for one update at a time, never while
+// waiting for input, and the kernel drops it if the process dies. Appends
+// of one record are single O_APPEND writes, which need no lock.
+//
+// hrst.lock also maps a generation counter per resource. A change that
+// moves or renames records bumps it, telling other processes to rebuild
+// their indexes; records they only appended are picked up incrementally.
+
+static struct {
+    int fd;
+    uint32_t *generations;          // mapped from the lock file
+    uint32_t fallback[LOCK_RESOURCES];
+    int depth[LOCK_RESOURCES];      // nested holds in this process
+    int exclusive[LOCK_RESOURCES];
+    int ready;
+} locks;
+
+static void lockInit(void) {
+    if (locks.ready) return;
+    locks.ready = 1;
+    locks.generations = locks.fallback;
+    size_t size = sizeof(uint32_t) * LOCK_RESOURCES;
+    locks.fd = open(LOCK_FILE, O_RDWR | O_CREAT, 0644);
+    struct stat st;
+    if (locks.fd >= 0 && fstat(locks.fd, &st) == 0 &&
+        ((size_t)st.st_size >= size || ftruncate(locks.fd, (off_t)size) == 0)) {
+        void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, locks.fd, 0);
+        if (base != MAP_FAILED) {
+            locks.generations = base;
+            return;
         }
-    } else {
-        printf("Deletion canceled.\n");
     }
-    pauseProgram();
+    printf("Warning: Could not open %s; other hrst processes will not be coordinated.\n", LOCK_FILE);
+    if (locks.fd >= 0) close(locks.fd);
+    locks.fd = -1;
 }
 
-void showProfiles(Profile profiles[], int count) {
-    if (count == 0) {
-        printf("No profiles available.\n");
-        return;
+static int lockRange(LockResource resource, short type) {
+    if (locks.fd < 0) return 1;
+    struct flock fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type = type;
+    fl.l_whence = SEEK_SET;
+    fl.l_start = resource;
+    fl.l_len = 1;
+    int rc;
+    while ((rc = fcntl(locks.fd, F_SETLKW, &fl)) != 0 && errno == EINTR) {}
+    return rc == 0;
+}
+
+// Blocks until this process holds the resource. Holds nest; asking for
+// exclusive while holding shared upgrades the lock. Main thread only.
+int processLock(LockResource resource, int exclusive) {
+    lockInit();
+    if (locks.depth[resource] > 0 && (locks.exclusive[resource] || !exclusive)) {
+        locks.depth[resource]++;
+        return 1;
     }
-    printHeader("Player Profiles");
-    for (int i = 0; i < count; i++) {
-        printf("%d) %s  | Games Played: %d  Wins: %d  Losses: %d\n",
-               i + 1,
-               profiles[i].name,
-               profiles[i].gamesPlayed,
-               profiles[i].wins,
-               profiles[i].losses);
+    METRIC_TIMER_START(start);
+    if (!lockRange(resource, exclusive ? F_WRLCK : F_RDLCK)) {
+        printf("Error: Could not lock %s.\n", LOCK_FILE);
+        return 0;
     }
-    printFooter();
+    METRIC_TIMER_STOP(start, TIMER_LOCK_WAIT);
+    locks.exclusive[resource] = exclusive;
+    locks.depth[resource]++;
+    return 1;
 }
 
-void viewProfileDetails(Profile *p) {
-    if (!p) return;
-    printHeader("Profile Details");
-    printf("Name        : %s\n", p->name);
-    printf("Games Played: %d\n", p->gamesPlayed);
-    printf("Wins        : %d\n", p->wins);
-    printf("Losses      : %d\n", p->losses);
-    printFooter();
-    pauseProgram();
+void processUnlock(LockResource resource) {
+    if (locks.depth[resource] == 0 || --locks.depth[resource] > 0) return;
+    lockRange(resource, F_UNLCK);
+    locks.exclusive[resource] = 0;
 }
 
-void updateProfileStats(Profile *p, GameSession *session) {
-    if (!p || !session) return;
-    p->gamesPlayed += session->roundsPlayed;
-    p->wins += session->wins;
-    p->losses += session->losses;
+uint32_t lockGeneration(LockResource resource) {
+    lockInit();
+    return locks.generations[resource];
 }
 
-// GAME LOGIC
+// Call while holding the resource exclusively.
+void lockBumpGeneration(LockResource resource) {
+    lockInit();
+    locks.generations[resource]++;
+}
+
+// DURABLE STORAGE
+//
+// Every file a finished game touches is made durable together: the append
+// logs stay open and the mapped stores are updated in place, and all of
+// them are flushed to disk once per batch of games (group commit) rather
+// than once per file per game. Whole-file rewrites go to a temporary file
+// that is synced and then renamed over the original, so a crash leaves
+// either the old file or the new one, never a truncated mix.
+
+static struct {
+    int batchSize;
+    int pending;    // games finished since the last sync
+    int count;
+    char paths[MAX_DURABLE_FILES][MAX_LINE];
+    int fds[MAX_DURABLE_FILES];
+    ProfileStore *store;
+    Leaderboard *lb;
+} durable = {DEFAULT_SYNC_BATCH, 0, 0, {{0}}, {0}, NULL, NULL};
 
-int isValidBasicMove(const char *move) {
-    if (!move || strlen(move) != 1) return 0;
-    char c = (char)toupper(move[0]);
-    return (c == 'L' || c == 'R' || c == 'U' || c == 'D');
+// Returns a long-lived O_APPEND descriptor for path, opening it on first use.
+int durableOpenAppend(const char *path) {
+    for (int i = 0; i < durable.count; i++) {
+        if (strcmp(durable.paths[i], path) == 0) return durable.fds[i];
+    }
+    int fd = open(path, O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (fd < 0 || durable.count == MAX_DURABLE_FILES) return fd;
+    strncpy(durable.paths[durable.count], path, MAX_LINE - 1);
+    durable.fds[durable.count++] = fd;
+    return fd;
 }
 
-int isValidAdvancedMove(const char *move) {
-    if (!move || strlen(move) != 1) return 0;
-    char c = (char)toupper(move[0]);
-    return (c == 'A' || c == 'B' || c == 'C' || c == 'E');
+// Appends one complete record with a single write.
+int durableWrite(const char *path, const void *data, size_t len) {
+    int fd = durableOpenAppend(path);
+    METRIC_ADD(COUNTER_BYTES_APPENDED, len);
+    return fd >= 0 && write(fd, data, len) == (ssize_t)len;
 }
 
-int isValidMove(const char *move, int mode) {
-    if (mode == 1) {
-        return isValidBasicMove(move);
-    } else if (mode == 2) {
-        if (isValidAdvancedMove(move)) return 1;
-        if (strlen(move) == 2) {
-            char tmp[3];
-            strncpy(tmp, move, 2);
-            tmp[2] = '\0';
-            toUpperStr(tmp);
-            return (strcmp(tmp, "LU") == 0 || strcmp(tmp, "LD") == 0 || strcmp(tmp, "RU") == 0 || strcmp(tmp, "RD") == 0);
+void durableSetBatch(int games) {
+    durable.batchSize = games < 1 ? 1 : games;
+}
+
+// Registers the mapped stores that each sync flushes along with the logs.
+void durableAttach(ProfileStore *store, Leaderboard *lb) {
+    durable.store = store;
+    durable.lb = lb;
+}
+
+void durableGameDone(void) {
+    if (++durable.pending >= durable.batchSize) durableSync();
+}
+
+void durableSync(void) {
+    ProfileStore *store = durable.store;
+    Leaderboard *lb = durable.lb;
+    METRIC_TIMER_START(start);
+    METRIC_ADD(COUNTER_FSYNCS, durable.count);
+    for (int i = 0; i < durable.count; i++) fsync(durable.fds[i]);
+    if (store && store->file.base) msync(store->file.base, store->file.mapSize, MS_SYNC);
+    if (lb && lb->file.base) {
+        msync(lb->file.base, lb->file.mapSize, MS_SYNC);
+        msync(lb->topFile.base, lb->topFile.mapSize, MS_SYNC);
+    }
+    durable.pending = 0;
+    METRIC_TIMER_STOP(start, TIMER_DURABLE_SYNC);
+}
+
+// Final sync before exit; also writes out any buffered output.
+void durableShutdown(void) {
+    durableSync();
+    for (int i = 0; i < durable.count; i++) close(durable.fds[i]);
+    durable.count = 0;
+    fflush(stdout);
+}
+
+// Finishes a rewrite: syncs and closes tmp, renames it over path, then syncs
+// the directory so the rename itself survives a crash.
+int atomicReplaceFile(FILE *tmp, const char *tmpPath, const char *path) {
+    int ok = fflush(tmp) == 0 && fsync(fileno(tmp)) == 0;
+    ok = fclose(tmp) == 0 && ok;
+    if (!ok || rename(tmpPath, path) != 0) {
+        remove(tmpPath);
+        return 0;
+    }
+    int dir = open(".", O_RDONLY);
+    if (dir >= 0) {
+        fsync(dir);
+        close(dir);
+    }
+    return 1;
+}
+
+// PROFILE SEARCH
+//
+// The name order is built on the first search and then patched by every
+// add, rename and delete, so it costs nothing for stores that never search.
+
+static const Profile *orderRecords; // qsort has no context argument
+
+static int compareByName(const void *a, const void *b) {
+    return strcmp(orderRecords[*(const int *)a].name, orderRecords[*(const int *)b].name);
+}
+
+static const char *orderName(const ProfileStore *store, int pos) {
+    return store->records[store->order.ids[pos]].name;
+}
+
+static int orderEnsure(ProfileStore *store) {
+    NameOrder *o = &store->order;
+    if (o->built) return 1;
+    int cap = store->count > INITIAL_RECORD_CAPACITY ? store->count : INITIAL_RECORD_CAPACITY;
+    int *ids = malloc(sizeof(int) * (size_t)cap);
+    if (!ids) return 0;
+    for (int i = 0; i < store->count; i++) ids[i] = i;
+    orderRecords = store->records;
+    qsort(ids, (size_t)store->count, sizeof(int), compareByName);
+    free(o->ids);
+    o->ids = ids;
+    o->cap = cap;
+    o->built = 1;
+    return 1;
+}
+
+// First position in [lo, hi) whose name's first len bytes compare >= key
+// (or > key when `after` is set).
+static int orderBound(const ProfileStore *store, int lo, int hi, const char *key, size_t len, int after) {
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        int cmp = strncmp(orderName(store, mid), key, len);
+        if (cmp < 0 || (after && cmp == 0)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
         }
     }
-    return 0;
+    return lo;
+}
+
+// Called after record idx has been added at the end or renamed in place.
+static void orderInsert(ProfileStore *store, int idx) {
+    NameOrder *o = &store->order;
+    if (!o->built) return;
+    if (store->count > o->cap) {
+        int *ids = realloc(o->ids, sizeof(int) * (size_t)o->cap * 2);
+        if (!ids) {
+            o->built = 0; // rebuilt on the next search
+            return;
+        }
+        o->ids = ids;
+        o->cap *= 2;
+    }
+    int n = store->count - 1; // entries in the order, not counting idx
+    int pos = orderBound(store, 0, n, store->records[idx].name, MAX_NAME_LEN, 0);
+    memmove(&o->ids[pos + 1], &o->ids[pos], sizeof(int) * (size_t)(n - pos));
+    o->ids[pos] = idx;
+}
+
+// Called while record idx still holds the name it is filed under.
+static void orderRemove(ProfileStore *store, int idx) {
+    NameOrder *o = &store->order;
+    if (!o->built) return;
+    int pos = orderBound(store, 0, store->count, store->records[idx].name, MAX_NAME_LEN, 0);
+    memmove(&o->ids[pos], &o->ids[pos + 1], sizeof(int) * (size_t)(store->count - pos - 1));
+}
+
+// Points the entry for record `from` at record `to`. Called by a delete after
+// orderRemove, so the order holds one entry fewer than the store.
+static void orderMove(ProfileStore *store, int from, int to) {
+    NameOrder *o = &store->order;
+    if (!o->built) return;
+    int pos = orderBound(store, 0, store->count - 1, store->records[from].name, MAX_NAME_LEN, 0);
+    o->ids[pos] = to;
+}
+
+// Returns how many names start with prefix; they are store->order.ids[*first]
+// onwards.
+int profilePrefixSearch(ProfileStore *store, const char *prefix, int *first) {
+    *first = 0;
+    if (!orderEnsure(store)) return 0;
+    size_t len = strlen(prefix);
+    int lo = orderBound(store, 0, store->count, prefix, len, 0);
+    int hi = orderBound(store, lo, store->count, prefix, len, 1);
+    *first = lo;
+    return hi - lo;
+}
+
+// Finds names within maxDist edits (insert, delete, substitute) of query,
+// closest first. The names are visited in sorted order, so consecutive names
+// reuse the edit-distance rows of their common prefix, and once every entry
+// of a row exceeds maxDist all names sharing that prefix are skipped at once.
+int profileFuzzySearch(ProfileStore *store, const char *query, int maxDist, int *out, int maxOut) {
+    if (!orderEnsure(store) || maxOut <= 0) return 0;
+    int dists[PROFILE_SEARCH_LIMIT];
+    if (maxOut > PROFILE_SEARCH_LIMIT) maxOut = PROFILE_SEARCH_LIMIT;
+    int qlen = (int)strnlen(query, MAX_NAME_LEN - 1);
+    int rows[MAX_NAME_LEN][MAX_NAME_LEN]; // rows[d][j]: distance of name[0..d) to query[0..j)
+    for (int j = 0; j <= qlen; j++) rows[0][j] = j;
+
+    const char *prev = "";
+    int valid = 0; // rows[0..valid] hold prev's prefixes
+    int found = 0;
+    int i = 0;
+    while (i < store->count && found < maxOut) {
+        const char *name = orderName(store, i);
+        int d = 0;
+        while (d < valid && name[d] && name[d] == prev[d]) d++;
+        int pruned = 0;
+        while (name[d]) {
+            const int *up = rows[d];
+            int *row = rows[d + 1];
+            int best = row[0] = d + 1;
+            for (int j = 1; j <= qlen; j++) {
+                int v = up[j - 1] + (name[d] != query[j - 1]);
+                if (up[j] + 1 < v) v = up[j] + 1;
+                if (row[j - 1] + 1 < v) v = row[j - 1] + 1;
+                row[j] = v;
+                if (v < best) best = v;
+            }
+            d++;
+            if (best > maxDist) {
+                pruned = 1;
+                break;
+            }
+        }
+        prev = name;
+        valid = d;
+        if (pruned) {
+            i = orderBound(store, i, store->count, name, (size_t)d, 1);
+            continue;
+        }
+        if (rows[d][qlen] <= maxDist) {
+            // Insertion by distance; names of equal distance stay in name order
+            int k = found++;
+            while (k > 0 && dists[k - 1] > rows[d][qlen]) {
+                out[k] = out[k - 1];
+                dists[k] = dists[k - 1];
+                k--;
+            }
+            out[k] = store->order.ids[i];
+            dists[k] = rows[d][qlen];
+        }
+        i++;
+    }
+    return found;
 }
 
-const char *mapAdvancedMove(const char *input) {
-    static char move[3];
-    if (!input) return NULL;
-    char c = (char)toupper(input[0]);
-    switch (c) {
-        case 'A': strcpy(move, "LU"); break;
-        case 'B': strcpy(move, "LD"); break;
-        case 'C': strcpy(move, "RU"); break;
-        case 'E': strcpy(move, "RD"); break;
-        default: return NULL;
+static void showProfilePage(const ProfileStore *store, const int *ids, int count, int page) {
+    int start = page * PROFILE_PAGE_SIZE;
+    int end = start + PROFILE_PAGE_SIZE < count ? start + PROFILE_PAGE_SIZE : count;
+    printHeader("Player Profiles");
+    for (int i = start; i < end; i++) {
+        const Profile *p = &store->records[ids[i]];
+        printf("%d) %s  | Games Played: %d  Wins: %d  Losses: %d\n",
+               i + 1,
+               p->name,
+               p->gamesPlayed,
+               p->wins,
+               p->losses);
+    }
+    printFooter();
+    printf("Showing %d-%d of %d.\n", start + 1, end, count);
+}
+
+// Pages through the profiles in name order. The user picks one by its number
+// or exact name, narrows the list with a name prefix or with ~name for
+// approximate matches, or enters 0 to cancel. Returns the record index or -1.
+// With no action the list is only browsed and nothing can be picked.
+int selectProfile(ProfileStore *store, const char *action) {
+    // Picks up other processes' changes; the caller rechecks its pick by name
+    // under the lock before changing anything
+    if (!storeLock(store, 0)) return -1;
+    storeUnlock(store);
+    if (store->count == 0) {
+        printf("No profiles available.\n");
+        return -1;
+    }
+    if (!orderEnsure(store)) return -1;
+    int found[PROFILE_SEARCH_LIMIT];
+    const int *ids = store->order.ids;
+    int count = store->count;
+    int page = 0;
+    while (1) {
+        showProfilePage(store, ids, count, page);
+        if (action) {
+            printf("Select profile to %s (number, name, prefix or ~name; Enter for more, 0 to cancel): ", action);
+        } else {
+            printf("Filter by prefix or ~name (Enter for more, 0 to return): ");
+        }
+        char *line = inputLine();
+        if (!line) endOfInput();
+        if (line[0] == '\0') {
+            page = (page + 1) * PROFILE_PAGE_SIZE < count ? page + 1 : 0;
+            continue;
+        }
+        char *end;
+        long n = strtol(line, &end, 10);
+        if (*end == '\0') {
+            if (n == 0) return -1;
+            if (action && n >= 1 && n <= count) return ids[n - 1];
+            if (action) {
+                printf("Please enter a number between 1 and %d.\n", count);
+            } else {
+                printf("Enter 0 to return.\n");
+            }
+            continue;
+        }
+        int exact = findProfileIndex(store, line);
+        if (action && exact != -1) return exact;
+
+        int matches;
+        const int *matched;
+        if (line[0] == '~') {
+            int len = (int)strlen(line + 1);
+            matches = profileFuzzySearch(store, line + 1, len <= 4 ? 1 : 2, found, PROFILE_SEARCH_LIMIT);
+            matched = found;
+        } else {
+            int first;
+            matches = profilePrefixSearch(store, line, &first);
+            matched = store->order.ids + first;
+        }
+        if (matches == 0) {
+            printf("No profiles match '%s'.\n", line);
+            continue;
+        }
+        if (action && matches == 1) return matched[0];
+        ids = matched;
+        count = matches;
+        page = 0;
+    }
+}
+
+// PROFILE STORE
+
+static void setProfileCount(ProfileStore *store, int count) {
+    store->count = count;
+    store->file.header->count = (uint32_t)count;
+}
+
+// Converts an older profiles.dat into the current format: either a
+// headerless file (a bare array of ProfileV1 records) or a version 1 file.
+// The new file is written aside and renamed over the old one, so an
+// interrupted migration leaves the original untouched.
+static int migrateProfiles(void) {
+    FILE *in = fopen(PROFILE_FILE, "rb");
+    if (!in) return 1; // nothing to migrate
+    FileHeader old;
+    memset(&old, 0, sizeof(old));
+    size_t got = fread(&old, 1, sizeof(old), in);
+    uint32_t remaining = UINT32_MAX;
+    if (got >= 4 && memcmp(old.magic, PROFILE_MAGIC, 4) == 0) {
+        if (got < sizeof(old) || old.version != 1 || old.byteOrder != BYTE_ORDER_MARK ||
+            old.recordSize != sizeof(ProfileV1)) {
+            fclose(in);
+            return 1; // current, or not ours to convert: mapOpen validates it
+        }
+        remaining = old.count;
+    } else if (got == 0) {
+        fclose(in);
+        return 1;
+    } else {
+        rewind(in);
+    }
+
+    const char *tmpPath = PROFILE_FILE ".tmp";
+    FILE *out = fopen(tmpPath, "wb");
+    if (!out) {
+        fclose(in);
+        return 0;
+    }
+    FileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, PROFILE_MAGIC, 4);
+    h.version = PROFILE_VERSION;
+    h.byteOrder = BYTE_ORDER_MARK;
+    h.recordSize = sizeof(Profile);
+    fwrite(&h, sizeof(h), 1, out);
+
+    ProfileV1 v1;
+    while (h.count < remaining && fread(&v1, sizeof(ProfileV1), 1, in) == 1) {
+        Profile p;
+        memset(&p, 0, sizeof(p));
+        memcpy(p.name, v1.name, MAX_NAME_LEN - 1);
+        p.gamesPlayed = v1.gamesPlayed;
+        p.wins = v1.wins;
+        p.losses = v1.losses;
+        fwrite(&p, sizeof(Profile), 1, out);
+        h.count++;
+    }
+    h.capacity = h.count;
+    fclose(in);
+
+    rewind(out);
+    fwrite(&h, sizeof(h), 1, out);
+    if (!atomicReplaceFile(out, tmpPath, PROFILE_FILE)) return 0;
+    printf("Migrated %u profiles to the new profile file format.\n", h.count);
+    return 1;
+}
+
+int loadProfiles(ProfileStore *store) {
+    memset(store, 0, sizeof(*store));
+    METRIC_TIMER_START(start);
+    // Exclusive, so only one process migrates or creates the file
+    if (!processLock(LOCK_PROFILES, 1)) return 0;
+    int ok = migrateProfiles() &&
+             mapOpen(&store->file, PROFILE_FILE, PROFILE_MAGIC, PROFILE_VERSION, sizeof(Profile));
+    if (ok) {
+        store->records = mapRecords(&store->file);
+        store->count = (int)store->file.header->count;
+        store->index.base = (const char *)store->records;
+        store->index.stride = sizeof(Profile);
+        store->generation = lockGeneration(LOCK_PROFILES);
+    }
+    processUnlock(LOCK_PROFILES);
+    METRIC_TIMER_STOP(start, TIMER_PROFILE_LOAD);
+    return ok;
+}
+
+// Catches up with what other processes changed while the store was unlocked:
+// maps any growth of the file, files appended profiles into the index and
+// name order, and drops both to be rebuilt if records were moved or renamed.
+static int storeRefresh(ProfileStore *store) {
+    if (!mapRefresh(&store->file)) return 0;
+    store->records = mapRecords(&store->file);
+    store->index.base = (const char *)store->records;
+    int count = (int)store->file.header->count;
+    uint32_t generation = lockGeneration(LOCK_PROFILES);
+    if (generation != store->generation) {
+        store->generation = generation;
+        store->count = count;
+        free(store->index.slots);
+        store->index.slots = NULL;
+        store->index.size = 0;
+        store->order.built = 0;
+        return 1;
+    }
+    if (!indexAppend(&store->index, store->count, count)) return 0;
+    while (store->count < count) {
+        store->count++;
+        if (store->order.built) orderInsert(store, store->count - 1);
+    }
+    return 1;
+}
+
+// Locks the store against other processes and brings this one's view of it
+// up to date. Hold it only around reads or updates, never across input.
+int storeLock(ProfileStore *store, int exclusive) {
+    if (!processLock(LOCK_PROFILES, exclusive)) return 0;
+    if (!storeRefresh(store)) {
+        processUnlock(LOCK_PROFILES);
+        printf("Error: Could not reload %s.\n", PROFILE_FILE);
+        return 0;
+    }
+    return 1;
+}
+
+void storeUnlock(ProfileStore *store) {
+    (void)store;
+    processUnlock(LOCK_PROFILES);
+}
+
+void closeProfiles(ProfileStore *store) {
+    mapClose(&store->file);
+    free(store->index.slots);
+    free(store->order.ids);
+    memset(store, 0, sizeof(*store));
+}
+
+// Records are updated in place through the mapping; this just schedules the
+// dirty page for write-back.
+int saveProfile(ProfileStore *store, int idx) {
+    long page = sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)&store->records[idx] & ~(uintptr_t)(page - 1);
+    uintptr_t end = (uintptr_t)&store->records[idx + 1];
+    METRIC_TIMER_START(syncStart);
+    int ok = msync((void *)start, end - start, MS_ASYNC) == 0;
+    METRIC_TIMER_STOP(syncStart, TIMER_PROFILE_SAVE);
+    if (!ok) {
+        printf("Error: Could not save profile.\n");
+        return 0;
+    }
+    return 1;
+}
+
+int findProfileIndex(ProfileStore *store, const char *name) {
+    if (!ensureIndex(&store->index, store->count, store->count + 1)) return -1;
+    return store->index.slots[indexSlot(&store->index, name)];
+}
+
+// The mutators below expect storeLock(store, 1) to be held whenever other
+// processes may share the files.
+int storeAddProfile(ProfileStore *store, const Profile *p) {
+    if (!ensureIndex(&store->index, store->count, store->count + 1)) return 0;
+    if (!mapReserve(&store->file, (uint32_t)store->count + 1)) return 0;
+    store->records = mapRecords(&store->file);
+    store->index.base = (const char *)store->records;
+    int idx = store->count;
+    store->records[idx] = *p;
+    store->index.slots[indexSlot(&store->index, p->name)] = idx;
+    setProfileCount(store, store->count + 1);
+    orderInsert(store, idx);
+    return saveProfile(store, idx);
+}
+
+int storeRenameProfile(ProfileStore *store, int idx, const char *newName) {
+    NameIndex *ix = &store->index;
+    if (!ensureIndex(ix, store->count, store->count)) return 0;
+    indexErase(ix, indexSlot(ix, store->records[idx].name));
+    orderRemove(store, idx);
+    memset(store->records[idx].name, 0, MAX_NAME_LEN);
+    strncpy(store->records[idx].name, newName, MAX_NAME_LEN - 1);
+    ix->slots[indexSlot(ix, store->records[idx].name)] = idx;
+    orderInsert(store, idx);
+    lockBumpGeneration(LOCK_PROFILES);
+    store->generation = lockGeneration(LOCK_PROFILES);
+    return saveProfile(store, idx);
+}
+
+// Moves the last record into the freed slot; the file keeps its capacity.
+int storeDeleteProfile(ProfileStore *store, int idx) {
+    NameIndex *ix = &store->index;
+    if (!ensureIndex(ix, store->count, store->count)) return 0;
+    int last = store->count - 1;
+    indexErase(ix, indexSlot(ix, store->records[idx].name));
+    orderRemove(store, idx);
+    if (idx != last) {
+        ix->slots[indexSlot(ix, store->records[last].name)] = idx;
+        orderMove(store, last, idx);
+        store->records[idx] = store->records[last];
+    }
+    memset(&store->records[last], 0, sizeof(Profile));
+    setProfileCount(store, last);
+    lockBumpGeneration(LOCK_PROFILES);
+    store->generation = lockGeneration(LOCK_PROFILES);
+    return saveProfile(store, idx);
+}
+
+// PROFILE MANAGEMENT
+
+void addNewProfile(ProfileStore *store) {
+    char name[MAX_NAME_LEN];
+    printf("Enter new player name: ");
+    if (!readLine(name, MAX_NAME_LEN)) {
+        printf("Input error.\n");
+        pauseProgram();
+        return;
+    }
+    if (strlen(name) == 0) {
+        printf("Name cannot be empty.\n");
+        pauseProgram();
+        return;
+    }
+    if (!storeLock(store, 1)) {
+        pauseProgram();
+        return;
+    }
+    if (findProfileIndex(store, name) != -1) {
+        storeUnlock(store);
+        printf("Profile with this name already exists.\n");
+        pauseProgram();
+        return;
+    }
+    Profile newProfile = {0};
+    strncpy(newProfile.name, name, MAX_NAME_LEN - 1);
+    newProfile.gamesPlayed = 0;
+    newProfile.wins = 0;
+    newProfile.losses = 0;
+
+    int ok = storeAddProfile(store, &newProfile);
+    storeUnlock(store);
+    if (!ok) {
+        printf("Failed to save profiles.\n");
+    } else {
+        printf("Profile '%s' added successfully.\n", name);
+    }
+    pauseProgram();
+}
+
+void renameProfile(ProfileStore *store) {
+    if (store->count == 0) {
+        printf("No profiles available.\n");
+        pauseProgram();
+        return;
+    }
+    int idx = selectProfile(store, "rename");
+    if (idx == -1) return;
+    char oldName[MAX_NAME_LEN];
+    strcpy(oldName, store->records[idx].name);
+    printf("Current name: %s\n", oldName);
+    printf("Enter new name: ");
+    char newName[MAX_NAME_LEN];
+    if (!readLine(newName, MAX_NAME_LEN)) {
+        printf("Input error.\n");
+        pauseProgram();
+        return;
+    }
+    if (strlen(newName) == 0) {
+        printf("Name cannot be empty.\n");
+        pauseProgram();
+        return;
+    }
+    if (!storeLock(store, 1)) {
+        pauseProgram();
+        return;
+    }
+    // Another process may have changed the store while we waited for input
+    idx = findProfileIndex(store, oldName);
+    int ok = 0;
+    if (idx == -1) {
+        printf("'%s' was renamed or deleted by another game.\n", oldName);
+    } else if (findProfileIndex(store, newName) != -1) {
+        printf("Another profile with this name exists.\n");
+    } else if (!storeRenameProfile(store, idx, newName)) {
+        printf("Failed to save profiles.\n");
+    } else {
+        ok = 1;
+    }
+    storeUnlock(store);
+    if (ok) printf("Profile renamed successfully.\n");
+    pauseProgram();
+}
+
+void deleteProfile(ProfileStore *store) {
+    if (store->count == 0) {
+        printf("No profiles to delete.\n");
+        pauseProgram();
+        return;
+    }
+    int idx = selectProfile(store, "delete");
+    if (idx == -1) return;
+    char name[MAX_NAME_LEN];
+    strcpy(name, store->records[idx].name);
+    printf("Are you sure you want to delete '%s'? This cannot be undone.\n", name);
+    if (confirmYesNo("Confirm deletion")) {
+        if (!storeLock(store, 1)) {
+            pauseProgram();
+            return;
+        }
+        idx = findProfileIndex(store, name);
+        int ok = idx != -1 && storeDeleteProfile(store, idx);
+        storeUnlock(store);
+        if (idx == -1) {
+            printf("'%s' was renamed or deleted by another game.\n", name);
+        } else if (!ok) {
+            printf("Failed to save profiles.\n");
+        } else {
+            printf("Profile deleted.\n");
+        }
+    } else {
+        printf("Deletion canceled.\n");
+    }
+    pauseProgram();
+}
+
+void viewProfileDetails(Profile *p) {
+    if (!p) return;
+    printHeader("Profile Details");
+    printf("Name        : %s\n", p->name);
+    printf("Games Played: %d\n", p->gamesPlayed);
+    printf("Wins        : %d\n", p->wins);
+    printf("Losses      : %d\n", p->losses);
+    printFooter();
+    pauseProgram();
+}
+
+void updateProfileStats(Profile *p, GameSession *session) {
+    if (!p || !session) return;
+    p->gamesPlayed += session->roundsPlayed;
+    p->wins += session->wins;
+    p->losses += session->losses;
+}
+
+// Persists a finished game: score log for wins, profile totals and the stats
+// log. The profile is looked up by name and created if it does not exist.
+// Totals are added and the model's changes since startModel merged into the
+// stored record under the lock, so games other processes finish for the same
+// player meanwhile are kept, not overwritten. With no startModel the model
+// replaces the stored one.
+void recordGameResult(ProfileStore *store, Leaderboard *lb, GameSession *session, int mode,
+                      const OpponentModel *startModel, const OpponentModel *model) {
+    METRIC_TIMER_START(start);
+    METRIC_ADD(COUNTER_GAMES_RECORDED, 1);
+    if (session->wins > session->losses) {
+        saveScoreToFile(lb, session);
+    }
+    // The game has been played either way, so it is logged even if the
+    // profile cannot be updated
+    if (storeLock(store, 1)) {
+        int idx = findProfileIndex(store, session->playerName);
+        if (idx == -1) {
+            Profile p = {0};
+            snprintf(p.name, sizeof(p.name), "%s", session->playerName);
+            if (storeAddProfile(store, &p)) idx = store->count - 1;
+        }
+        if (idx != -1) {
+            updateProfileStats(&store->records[idx], session);
+            modelMerge(&store->records[idx].model, startModel, model);
+            saveProfile(store, idx);
+        }
+        storeUnlock(store);
+        if (idx == -1) printf("Error saving profile.\n");
+    } else {
+        printf("Error saving profile.\n");
+    }
+    saveGameStats(session, mode);
+    durableGameDone();
+    METRIC_TIMER_STOP(start, TIMER_GAME_RECORD);
+}
+
+// RANDOM NUMBERS
+
+static uint64_t splitMix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static uint64_t rotl64(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static uint32_t pcg32(Rng *rng) {
+    uint64_t old = rng->s[0];
+    rng->s[0] = old * 6364136223846793005ull + rng->s[1];
+    uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+    uint32_t rot = (uint32_t)(old >> 59);
+    return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+}
+
+// Expands a 64-bit seed into full engine state with SplitMix64.
+void rngSeed(Rng *rng, RngEngine engine, uint64_t seed) {
+    memset(rng, 0, sizeof(*rng));
+    rng->engine = engine;
+    uint64_t x = seed;
+    if (engine == RNG_PCG) {
+        rng->s[1] = (splitMix64(&x) << 1) | 1; // increment must be odd
+        rng->s[0] = splitMix64(&x) + rng->s[1];
+        pcg32(rng);
+    } else {
+        for (int i = 0; i < 4; i++) rng->s[i] = splitMix64(&x);
+    }
+}
+
+// Derives a non-overlapping stream for worker `stream`: xoshiro jumps 2^128
+// steps ahead per stream, PCG switches to a different increment.
+void rngSplit(Rng *child, const Rng *parent, int stream) {
+    static const uint64_t jump[4] = {
+        0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull,
+        0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull
+    };
+    *child = *parent;
+    if (parent->engine == RNG_PCG) {
+        child->s[1] = (parent->s[1] + 2 * (uint64_t)stream * 0x9E3779B97F4A7C15ull) | 1;
+        return;
+    }
+    for (int n = 0; n < stream; n++) {
+        uint64_t t[4] = {0, 0, 0, 0};
+        for (int i = 0; i < 4; i++) {
+            for (int b = 0; b < 64; b++) {
+                if (jump[i] & (1ull << b)) {
+                    for (int k = 0; k < 4; k++) t[k] ^= child->s[k];
+                }
+                rngNext(child);
+            }
+        }
+        memcpy(child->s, t, sizeof(t));
+    }
+}
+
+uint64_t rngNext(Rng *rng) {
+    if (rng->engine == RNG_PCG) {
+        uint64_t hi = pcg32(rng);
+        return (hi << 32) | pcg32(rng);
+    }
+    uint64_t *s = rng->s;
+    uint64_t result = rotl64(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl64(s[3], 45);
+    return result;
+}
+
+// Uniform value in [0, bound) without modulo bias (Lemire's method).
+uint32_t rngBounded(Rng *rng, uint32_t bound) {
+    uint64_t m = (rngNext(rng) >> 32) * (uint64_t)bound;
+    uint32_t low = (uint32_t)m;
+    if (low < bound) {
+        uint32_t threshold = -bound % bound;
+        while (low < threshold) {
+            m = (rngNext(rng) >> 32) * (uint64_t)bound;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+// Fills moves[] with choices in 0-3. Four is a power of two, so each 64-bit
+// draw yields 32 unbiased moves.
+void rngFillMoves(Rng *rng, uint8_t *moves, int count) {
+    while (count > 0) {
+        uint64_t bits = rngNext(rng);
+        int n = count < 32 ? count : 32;
+        for (int i = 0; i < n; i++) {
+            moves[i] = (uint8_t)(bits & 3);
+            bits >>= 2;
+        }
+        moves += n;
+        count -= n;
+    }
+}
+
+// Seed used when none is given on the command line
+uint64_t defaultSeed(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t x = ((uint64_t)ts.tv_sec << 32) ^ (uint64_t)ts.tv_nsec ^ ((uint64_t)getpid() << 16);
+    return splitMix64(&x);
+}
+
+// GAME RULES
+//
+// Moves, aliases and scoring come from rules.cfg when it exists, otherwise
+// from defaultRules below, which doubles as the reference for the format.
+// Both are compiled into lookup tables once at startup and only read after
+// that, so game threads share them freely.
+
+static const char defaultRules[] =
+    "# Each mode has 2-4 moves of one or two characters, optional aliases\n"
+    "# (alias <key> <move>) and a win rule: \"win differ\", \"win match\", or\n"
+    "# one \"beats <move> <moves it beats...>\" line per move. Input is\n"
+    "# case-insensitive.\n"
+    "mode 1 Basic\n"
+    "move L Left\n"
+    "move R Right\n"
+    "move U Up\n"
+    "move D Down\n"
+    "win differ\n"
+    "\n"
+    "mode 2 Advanced\n"
+    "move LU Left-Up\n"
+    "move LD Left-Down\n"
+    "move RU Right-Up\n"
+    "move RD Right-Down\n"
+    "alias A LU\n"
+    "alias B LD\n"
+    "alias C RU\n"
+    "alias E RD\n"
+    "win differ\n";
+
+static Rules rules;
+static pthread_once_t rulesOnce = PTHREAD_ONCE_INIT;
+
+static int rulesError(const char *source, int line, const char *message, const char *word) {
+    printf("%s line %d: %s%s%s.\n", source, line, message, word ? " " : "", word ? word : "");
+    return 0;
+}
+
+static int modeError(const char *source, const ModeRules *m, const char *message, const char *word) {
+    printf("%s, %s mode: %s%s%s.\n", source, m->title, message, word ? " " : "", word ? word : "");
+    return 0;
+}
+
+static int findRuleMove(const ModeRules *m, const char *name) {
+    for (int i = 0; i < m->moveCount; i++) {
+        if (strcasecmp(m->names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+// Gives each character of token a class, upper and lower case sharing one.
+static int classifyToken(Rules *r, const char *token) {
+    for (const char *p = token; *p; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (r->charClass[c]) continue;
+        if (r->classCount == RULES_CLASSES - 1) return 0;
+        int cls = ++r->classCount;
+        r->charClass[toupper(c)] = (uint8_t)cls;
+        r->charClass[tolower(c)] = (uint8_t)cls;
+    }
+    return 1;
+}
+
+static int addToken(Rules *r, ModeRules *m, const char *token, int move) {
+    if (!classifyToken(r, token)) return 0;
+    int8_t *slot = &m->tokens[r->charClass[(unsigned char)token[0]]][r->charClass[(unsigned char)token[1]]];
+    if (*slot != -1) return 0;
+    *slot = (int8_t)move;
+    return 1;
+}
+
+static void appendText(char *buf, size_t size, const char *text) {
+    strncat(buf, text, size - strlen(buf) - 1);
+}
+
+// Builds a parsed mode's tables: tokens, win bits, the computer's counters
+// and the prompt hints.
+static int compileMode(Rules *r, int mode, const char *source) {
+    ModeRules *m = &r->modes[mode - 1];
+    if (m->moveCount < 2) return modeError(source, m, "needs at least 2 moves", NULL);
+    memset(m->tokens, -1, sizeof(m->tokens));
+    for (int i = 0; i < m->moveCount; i++) {
+        if (!addToken(r, m, m->names[i], i)) {
+            return modeError(source, m, "duplicate move or too many distinct characters:", m->names[i]);
+        }
+        strcpy(m->inputs[i], m->names[i]);
+    }
+    for (int a = m->aliasCount - 1; a >= 0; a--) {
+        if (!addToken(r, m, m->aliases[a], m->aliasMoves[a])) {
+            return modeError(source, m, "alias clashes or too many distinct characters:", m->aliases[a]);
+        }
+        if (strlen(m->aliases[a]) <= strlen(m->inputs[m->aliasMoves[a]])) {
+            strcpy(m->inputs[m->aliasMoves[a]], m->aliases[a]); // first alias wins a tie
+        }
+    }
+
+    for (int p = 0; p < m->moveCount; p++) {
+        uint8_t all = (uint8_t)((1u << m->moveCount) - 1);
+        if (m->winRule == WIN_DIFFER) m->beats[p] = (uint8_t)(all & ~(1u << p));
+        if (m->winRule == WIN_MATCH) m->beats[p] = (uint8_t)(1u << p);
+        // Against a predicted move the computer plays the first move it does
+        // not lose to, preferring the predicted move itself
+        int answer = p;
+        for (int k = 0; k < m->moveCount && (m->beats[p] >> answer & 1); k++) answer = (p + k + 1) % m->moveCount;
+        m->counter[p] = (uint8_t)answer;
+        for (int c = 0; c < m->moveCount; c++) {
+            r->playerWins[pickMove(mode, p)][pickMove(mode, c)] = m->beats[p] >> c & 1;
+        }
+    }
+
+    m->moveHint[0] = '\0';
+    m->keyHint[0] = '\0';
+    for (int a = 0; a < m->aliasCount; a++) {
+        char part[16];
+        snprintf(part, sizeof(part), "%s%s=%s", a ? ", " : "", m->aliases[a], m->names[m->aliasMoves[a]]);
+        appendText(m->moveHint, sizeof(m->moveHint), part);
+    }
+    if (m->aliasCount) appendText(m->moveHint, sizeof(m->moveHint), " or full ");
+    for (int i = 0; i < m->moveCount; i++) {
+        if (i) {
+            appendText(m->moveHint, sizeof(m->moveHint), m->aliasCount ? "/" : ",");
+            appendText(m->keyHint, sizeof(m->keyHint), "/");
+        }
+        appendText(m->moveHint, sizeof(m->moveHint), m->names[i]);
+        appendText(m->keyHint, sizeof(m->keyHint), m->inputs[i]);
+    }
+    return 1;
+}
+
+// A replay depends on each mode's move count, the adaptive opponent's
+// counters and the outcome table. Titles, hints and aliases can change
+// without touching the fingerprint.
+static uint32_t hashRules(const Rules *r) {
+    unsigned char buf[2 * (1 + RULES_MAX_MOVES) + sizeof(r->playerWins)];
+    unsigned char *p = buf;
+    for (int m = 0; m < 2; m++) {
+        *p++ = (unsigned char)r->modes[m].moveCount;
+        memcpy(p, r->modes[m].counter, RULES_MAX_MOVES);
+        p += RULES_MAX_MOVES;
+    }
+    memcpy(p, r->playerWins, sizeof(r->playerWins));
+    return crc32(buf, sizeof(buf));
+}
+
+// Parses rules text into r and compiles it. Errors are reported against
+// source; returns 0 if the text is not a complete, valid rule set.
+static int compileRules(Rules *r, const char *text, const char *source) {
+    memset(r, 0, sizeof(*r));
+    ModeRules *m = NULL;
+    int seen[2] = {0, 0};
+    int lineNo = 0;
+    while (*text) {
+        char line[256];
+        size_t len = strcspn(text, "\n");
+        lineNo++;
+        if (len >= sizeof(line)) return rulesError(source, lineNo, "line too long", NULL);
+        memcpy(line, text, len);
+        line[len] = '\0';
+        text += len + (text[len] == '\n');
+        char *comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+
+        char *words[RULES_MAX_MOVES + 2];
+        int n = 0;
+        char *save = NULL;
+        for (char *w = strtok_r(line, " \t\r", &save); w; w = strtok_r(NULL, " \t\r", &save)) {
+            if (n == RULES_MAX_MOVES + 2) return rulesError(source, lineNo, "too many words", NULL);
+            words[n++] = w;
+        }
+        if (n == 0) continue;
+
+        if (strcmp(words[0], "mode") == 0) {
+            int mode = n >= 3 ? atoi(words[1]) : 0;
+            if (mode != 1 && mode != 2) return rulesError(source, lineNo, "expected: mode <1|2> <title>", NULL);
+            if (seen[mode - 1]++) return rulesError(source, lineNo, "mode defined twice:", words[1]);
+            m = &r->modes[mode - 1];
+            snprintf(m->title, sizeof(m->title), "%s", words[2]);
+            continue;
+        }
+        if (!m) return rulesError(source, lineNo, "expected a mode line before", words[0]);
+
+        if (strcmp(words[0], "move") == 0) {
+            if (n < 2 || strlen(words[1]) > RULES_TOKEN_LEN) {
+                return rulesError(source, lineNo, "expected: move <1-2 characters> [description]", NULL);
+            }
+            if (m->moveCount == RULES_MAX_MOVES) return rulesError(source, lineNo, "too many moves", NULL);
+            char *name = m->names[m->moveCount];
+            strcpy(name, words[1]);
+            toUpperStr(name);
+            char *desc = m->descriptions[m->moveCount];
+            for (int i = 2; i < n; i++) {
+                appendText(desc, RULES_TEXT_LEN, i > 2 ? " " : "");
+                appendText(desc, RULES_TEXT_LEN, words[i]);
+            }
+            m->moveCount++;
+        } else if (strcmp(words[0], "alias") == 0) {
+            int move = n == 3 ? findRuleMove(m, words[2]) : -1;
+            if (move < 0 || strlen(words[1]) > RULES_TOKEN_LEN) {
+                return rulesError(source, lineNo, "expected: alias <1-2 characters> <move>", NULL);
+            }
+            if (m->aliasCount == RULES_MAX_ALIASES) return rulesError(source, lineNo, "too many aliases", NULL);
+            strcpy(m->aliases[m->aliasCount], words[1]);
+            toUpperStr(m->aliases[m->aliasCount]);
+            m->aliasMoves[m->aliasCount++] = (uint8_t)move;
+        } else if (strcmp(words[0], "win") == 0) {
+            if (n != 2 || (strcmp(words[1], "differ") != 0 && strcmp(words[1], "match") != 0)) {
+                return rulesError(source, lineNo, "expected: win <differ|match>", NULL);
+            }
+            m->winRule = strcmp(words[1], "differ") == 0 ? WIN_DIFFER : WIN_MATCH;
+        } else if (strcmp(words[0], "beats") == 0) {
+            int move = n >= 2 ? findRuleMove(m, words[1]) : -1;
+            if (move < 0) return rulesError(source, lineNo, "expected: beats <move> <moves...>", NULL);
+            m->winRule = WIN_TABLE;
+            for (int i = 2; i < n; i++) {
+                int beaten = findRuleMove(m, words[i]);
+                if (beaten < 0) return rulesError(source, lineNo, "unknown move", words[i]);
+                m->beats[move] |= (uint8_t)(1u << beaten);
+            }
+        } else {
+            return rulesError(source, lineNo, "unknown keyword", words[0]);
+        }
+    }
+    if (!seen[0] || !seen[1]) return rulesError(source, lineNo, "both mode 1 and mode 2 must be defined", NULL);
+    if (!compileMode(r, 1, source) || !compileMode(r, 2, source)) return 0;
+    r->hash = hashRules(r);
+    return 1;
+}
+
+static uint32_t builtinRulesHash;   // sessions logged before rule sets were recorded used these
+
+static void loadDefaultRules(void) {
+    compileRules(&rules, defaultRules, "built-in rules");
+    builtinRulesHash = rules.hash;
+}
+
+const Rules *gameRules(void) {
+    pthread_once(&rulesOnce, loadDefaultRules);
+    return &rules;
+}
+
+// Replaces the rules with the ones in path, or with RULES_FILE if path is
+// NULL and that file exists. Call before any game starts. Returns 0, keeping
+// the current rules, if the file cannot be read or is invalid.
+int loadRules(const char *path) {
+    gameRules();
+    const char *file = path ? path : RULES_FILE;
+    FILE *fp = fopen(file, "r");
+    if (!fp) {
+        if (!path) return 1;
+        printf("Error: Could not open %s.\n", file);
+        return 0;
+    }
+    char *text = malloc(RULES_MAX_SIZE + 1);
+    Rules *loaded = malloc(sizeof(Rules));
+    size_t len = text ? fread(text, 1, RULES_MAX_SIZE + 1, fp) : 0;
+    fclose(fp);
+    int ok = 0;
+    if (!text || !loaded) {
+        printf("Error: Out of memory loading %s.\n", file);
+    } else if (len > RULES_MAX_SIZE) {
+        printf("Error: %s is larger than %d bytes.\n", file, RULES_MAX_SIZE);
+    } else {
+        text[len] = '\0';
+        ok = compileRules(loaded, text, file);
+        if (ok) rules = *loaded;
+    }
+    free(text);
+    free(loaded);
+    return ok;
+}
+
+int moveCount(int mode) {
+    return gameRules()->modes[mode - 1].moveCount;
+}
+
+const char *modeName(int mode) {
+    return gameRules()->modes[mode - 1].title;
+}
+
+// "Use Advanced mode (A/B/C/E)?" for the rules in force
+static void modeQuestion(char *buf, size_t size) {
+    const ModeRules *m = &gameRules()->modes[1];
+    snprintf(buf, size, "Use %s mode (%s)?", m->title, m->keyHint);
+}
+
+// GAME LOGIC
+
+// Returns a string from the rules, so it is safe to call from several threads.
+const char *moveToString(Move move) {
+    return move == MOVE_NONE ? "?" : gameRules()->modes[(move >> 2) & 1].names[move & 3];
+}
+
+void setHistoryMove(uint64_t *history, int round, Move move) {
+    int shift = round * MOVE_BITS;
+    *history &= ~((uint64_t)7 << shift);
+    *history |= (uint64_t)move << shift;
+}
+
+Move getHistoryMove(uint64_t history, int round) {
+    return (Move)((history >> (round * MOVE_BITS)) & 7);
+}
+
+// Validates raw input for the mode and returns the move it stands for, or
+// MOVE_NONE if it is not a valid move: two character-class lookups and one
+// token lookup, for moves and aliases alike.
+Move parseMove(const char *input, int mode) {
+    const Rules *r = gameRules();
+    const unsigned char *s = (const unsigned char *)input;
+    int first = r->charClass[s[0]];
+    if (!first) return MOVE_NONE;
+    int second = r->charClass[s[1]];
+    if (second ? s[2] != '\0' : s[1] != '\0') return MOVE_NONE;
+    int move = r->modes[mode - 1].tokens[first][second];
+    return move < 0 ? MOVE_NONE : pickMove(mode, move);
+}
+
+int isValidMove(const char *move, int mode) {
+    return parseMove(move, mode) != MOVE_NONE;
+}
+
+Move pickMove(int mode, int choice) {
+    return (Move)((mode == 2 ? 4 : 0) | (choice & 3));
+}
+
+Move computerMove(Rng *rng, int mode) {
+    return pickMove(mode, (int)rngBounded(rng, (uint32_t)moveCount(mode)));
+}
+
+// Gives a game its own Rng, seeded by one draw from `source`. The seed is
+// logged with the session, which is all a replay needs besides the player's
+// moves.
+void seedSession(GameSession *session, Rng *game, Rng *source, OpponentKind opponent) {
+    session->seed = rngNext(source);
+    session->engine = source->engine;
+    session->opponent = opponent;
+    rngSeed(game, session->engine, session->seed);
+}
+
+// Context ids: 0-15 for the last two moves, 16-19 for the only move so far,
+// 20 at the start of a game.
+static int modelContext(uint64_t history, int round, int order) {
+    if (order == 2 && round >= 2) {
+        return (int)((getHistoryMove(history, round - 2) & 3) * 4 + (getHistoryMove(history, round - 1) & 3));
+    }
+    if (order >= 1 && round >= 1) {
+        return 16 + (int)(getHistoryMove(history, round - 1) & 3);
+    }
+    return 20;
+}
+
+// The move the player is most likely to make next. Backs off to shorter
+// contexts when the longer one has not been seen; ties are broken at random,
+// and with nothing learned yet the guess is random.
+Move predictMove(const OpponentModel *model, Rng *rng, int mode, uint64_t history, int round) {
+    for (int order = 2; order >= 0; order--) {
+        const uint8_t *c = model->counts[mode - 1][modelContext(history, round, order)];
+        int best = c[0] > c[1] ? c[0] : c[1];
+        best = best > c[2] ? best : c[2];
+        best = best > c[3] ? best : c[3];
+        if (best == 0) continue;
+        int ties[4];
+        int n = 0;
+        for (int i = 0; i < 4; i++) {
+            if (c[i] == best) ties[n++] = i;
+        }
+        return pickMove(mode, n == 1 ? ties[0] : ties[rngBounded(rng, (uint32_t)n)]);
+    }
+    return computerMove(rng, mode);
+}
+
+// Answers the predicted move with the rules' counter to it (the same move,
+// under the standard rules). Without a model the computer plays at random.
+Move opponentMove(const OpponentModel *model, Rng *rng, int mode, uint64_t history, int round) {
+    if (!model) return computerMove(rng, mode);
+    Move guess = predictMove(model, rng, mode, history, round);
+    return pickMove(mode, gameRules()->modes[mode - 1].counter[guess & 3]);
+}
+
+// Counts the player's move `actual` in round `round` under every context order.
+void modelLearn(OpponentModel *model, int mode, uint64_t history, int round, Move actual) {
+    for (int order = 0; order <= 2; order++) {
+        if (order > round) break;
+        uint8_t *c = model->counts[mode - 1][modelContext(history, round, order)];
+        if (c[actual & 3] == UINT8_MAX) {
+            for (int i = 0; i < 4; i++) c[i] /= 2;
+        }
+        c[actual & 3]++;
+    }
+}
+
+// Folds what one game learned (after - before) into target, which other games
+// may have changed since `before` was taken. If none did, target == before
+// and the result is exactly `after`. With no `before`, after replaces target.
+void modelMerge(OpponentModel *target, const OpponentModel *before, const OpponentModel *after) {
+    if (!before) {
+        *target = *after;
+        return;
+    }
+    uint8_t *t = &target->counts[0][0][0];
+    const uint8_t *b = &before->counts[0][0][0];
+    const uint8_t *a = &after->counts[0][0][0];
+    for (size_t i = 0; i < sizeof(OpponentModel); i++) {
+        int v = t[i] + a[i] - b[i];
+        t[i] = (uint8_t)(v < 0 ? 0 : v > UINT8_MAX ? UINT8_MAX : v);
+    }
+}
+
+// Whether the player wins the round, as the rules' outcome table says.
+int scoreRound(Move playerMove, Move compMove) {
+    return gameRules()->playerWins[playerMove][compMove];
+}
+
+// GAME CORE
+//
+// One game, from the first round to the recorded result. The console and
+// every network client run their games through these functions and only
+// differ in where the text goes and how the moves are read.
+
+static void writeStdout(void *ctx, const char *text, size_t len) {
+    (void)ctx;
+    fwrite(text, 1, len, stdout);
+}
+
+static Output console = {writeStdout, NULL};
+
+void outPrintf(Output *out, const char *fmt, ...) {
+    char buf[MAX_LINE];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if (n < 0) return;
+    if ((size_t)n < sizeof(buf)) {
+        out->write(out->ctx, buf, (size_t)n);
+        return;
+    }
+    char *text = malloc((size_t)n + 1);
+    if (!text) return;
+    va_start(ap, fmt);
+    vsnprintf(text, (size_t)n + 1, fmt, ap);
+    va_end(ap);
+    out->write(out->ctx, text, (size_t)n);
+    free(text);
+}
+
+// Starts a game for the named player. Another process may have played or
+// removed the profile since it was picked, so its model is read afresh
+// under the lock.
+void gameBegin(GamePlay *game, ProfileStore *store, Rng *source, OpponentKind opponent,
+               const char *name, int mode, int rounds) {
+    memset(game, 0, sizeof(*game));
+    snprintf(game->session.playerName, sizeof(game->session.playerName), "%s", name);
+    game->session.roundsPlayed = rounds;
+    game->mode = mode;
+    game->opponent = opponent;
+    if (storeLock(store, 0)) {
+        int idx = findProfileIndex(store, game->session.playerName);
+        if (idx != -1) game->model = store->records[idx].model;
+        storeUnlock(store);
+    }
+    game->startModel = game->model;
+    seedSession(&game->session, &game->rng, source, opponent);
+}
+
+void gamePrompt(const GamePlay *game, Output *out) {
+    outPrintf(out, "Round %d\n", game->round + 1);
+    outPrintf(out, "Enter your move (%s): ", gameRules()->modes[game->mode - 1].moveHint);
+}
+
+// Plays the next round with the player's move; returns 1 once it was the last.
+int gamePlayRound(GamePlay *game, Move playerMove, Output *out) {
+    GameSession *s = &game->session;
+    int r = game->round;
+    Move compMove = opponentMove(game->opponent == OPPONENT_ADAPTIVE ? &game->model : NULL,
+                                 &game->rng, game->mode, s->movesHistory, r);
+
+    outPrintf(out, "Computer chose: %s\n", moveToString(compMove));
+
+    modelLearn(&game->model, game->mode, s->movesHistory, r, playerMove);
+    setHistoryMove(&s->movesHistory, r, playerMove);
+    setHistoryMove(&s->compMovesHistory, r, compMove);
+
+    if (scoreRound(playerMove, compMove)) {
+        outPrintf(out, "You WIN this round!\n\n");
+        s->wins++;
+    } else {
+        outPrintf(out, "You LOSE this round!\n\n");
+        s->losses++;
+    }
+    return ++game->round == s->roundsPlayed;
+}
+
+// Reports the result and records it in the profile, score and stats files.
+void gameFinish(GamePlay *game, ProfileStore *store, Leaderboard *lb, Output *out) {
+    GameSession *s = &game->session;
+    outPrintf(out, "%s", DIVIDER);
+    outPrintf(out, "Game over! %s's Results:\n", s->playerName);
+    outPrintf(out, "Rounds Played: %d\n", s->roundsPlayed);
+    outPrintf(out, "Wins: %d\n", s->wins);
+    outPrintf(out, "Losses: %d\n", s->losses);
+    outPrintf(out, "%s", DIVIDER);
+
+    if (s->wins > s->losses) {
+        outPrintf(out, "You won the game! Congratulations!\n");
+    } else if (s->wins < s->losses) {
+        outPrintf(out, "You lost the game. Better luck next time!\n");
+    } else {
+        outPrintf(out, "The game was a draw!\n");
+    }
+
+    recordGameResult(store, lb, s, game->mode, &game->startModel, &game->model);
+}
+
+void playGame(ProfileStore *store, Leaderboard *lb, Rng *rng, OpponentKind opponent) {
+    if (store->count == 0) {
+        printf("No profiles available. Please add one first.\n");
+        pauseProgram();
+        return;
+    }
+    int idx = selectProfile(store, "play");
+    if (idx == -1) return;
+
+    Profile *playerProfile = &store->records[idx];
+
+    printf("Welcome %s!\n", playerProfile->name);
+
+    int mode = 1;
+    char question[RULES_TEXT_LEN * 3];
+    modeQuestion(question, sizeof(question));
+    if (confirmYesNo(question)) {
+        mode = 2;
+    }
+
+    int rounds = getIntInRange("Enter number of rounds (1-20): ", 1, MAX_ROUNDS);
+
+    GamePlay game;
+    gameBegin(&game, store, rng, opponent, playerProfile->name, mode, rounds);
+
+    printEmptyLines(1);
+
+    int done = 0;
+    while (!done) {
+        gamePrompt(&game, &console);
+
+        char input[MAX_MOVE_LEN];
+        Move playerMove;
+        if (!readLine(input, MAX_MOVE_LEN)) {
+            printf("Input error, try again.\n");
+            continue;
+        }
+        if ((playerMove = parseMove(input, mode)) == MOVE_NONE) {
+            printf("Invalid move, please try again.\n");
+            continue;
+        }
+        done = gamePlayRound(&game, playerMove, &console);
+    }
+
+    gameFinish(&game, store, lb, &console);
+
+    pauseProgram();
+}
+
+// LEADERBOARD
+
+/* Ranking order: wins descending, then name ascending */
+int compare(const void *a, const void *b) {
+    const ScoreEntry *sa = (const ScoreEntry *)a;
+    const ScoreEntry *sb = (const ScoreEntry *)b;
+
+    /* wins descending */
+    if (sa->wins < sb->wins) return 1;
+    if (sa->wins > sb->wins) return -1;
+
+    /* tie-breaker: name ascending */
+    return strcmp(sa->name, sb->name);
+}
+
+static void refreshLeaderboardPointers(Leaderboard *lb) {
+    lb->entries = mapRecords(&lb->file);
+    lb->index.base = (const char *)lb->entries;
+    lb->top = mapRecords(&lb->topFile);
+}
+
+// Entries are only ever appended, so catching up with other processes means
+// mapping any growth and indexing the entries they added.
+static int leaderboardRefresh(Leaderboard *lb) {
+    if (!mapRefresh(&lb->file)) return 0;
+    refreshLeaderboardPointers(lb);
+    int count = (int)lb->file.header->count;
+    if (!indexAppend(&lb->index, lb->indexed, count)) return 0;
+    lb->indexed = count;
+    return 1;
+}
+
+int openLeaderboard(Leaderboard *lb) {
+    memset(lb, 0, sizeof(*lb));
+    lb->index.stride = sizeof(ScoreEntry);
+    if (!processLock(LOCK_LEADERBOARD, 1)) return 0;
+    int ok = mapOpen(&lb->file, LEADERBOARD_FILE, LEADERBOARD_MAGIC, LEADERBOARD_VERSION, sizeof(ScoreEntry));
+    if (ok && (!mapOpen(&lb->topFile, LEADERBOARD_TOP_FILE, LEADERBOARD_TOP_MAGIC, LEADERBOARD_VERSION, sizeof(int32_t)) ||
+               !mapReserve(&lb->topFile, LEADERBOARD_TOP_K))) {
+        mapClose(&lb->file);
+        ok = 0;
+    }
+    if (ok) {
+        refreshLeaderboardPointers(lb);
+        lb->indexed = (int)lb->file.header->count;
+        ok = leaderboardCatchUp(lb);
+    }
+    processUnlock(LOCK_LEADERBOARD);
+    return ok;
+}
+
+void closeLeaderboard(Leaderboard *lb) {
+    mapClose(&lb->file);
+    mapClose(&lb->topFile);
+    free(lb->index.slots);
+    memset(lb, 0, sizeof(*lb));
+}
+
+// Player scores only ever grow, so a player can only enter or move up the
+// top list when their own entry changes: one insertion step keeps it exact.
+static void leaderboardPromote(Leaderboard *lb, int32_t entry) {
+    FileHeader *h = lb->topFile.header;
+    int pos = -1;
+    for (int i = 0; i < (int)h->count; i++) {
+        if (lb->top[i] == entry) {
+            pos = i;
+            break;
+        }
+    }
+    if (pos == -1) {
+        if (h->count < LEADERBOARD_TOP_K) {
+            pos = (int)h->count++;
+        } else if (compare(&lb->entries[entry], &lb->entries[lb->top[h->count - 1]]) < 0) {
+            pos = (int)h->count - 1;
+        } else {
+            return;
+        }
+    }
+    while (pos > 0 && compare(&lb->entries[entry], &lb->entries[lb->top[pos - 1]]) < 0) {
+        lb->top[pos] = lb->top[pos - 1];
+        pos--;
+    }
+    lb->top[pos] = entry;
+}
+
+int leaderboardRecord(Leaderboard *lb, const char *name, int games, int wins, int losses) {
+    FileHeader *h = lb->file.header;
+    int count = (int)h->count;
+    if (!ensureIndex(&lb->index, count, count + 1)) return 0;
+    int slot = indexSlot(&lb->index, name);
+    int entry = lb->index.slots[slot];
+    if (entry == -1) {
+        if (!mapReserve(&lb->file, (uint32_t)count + 1)) return 0;
+        refreshLeaderboardPointers(lb);
+        h = lb->file.header;
+        entry = count;
+        memset(&lb->entries[entry], 0, sizeof(ScoreEntry));
+        strncpy(lb->entries[entry].name, name, MAX_NAME_LEN - 1);
+        lb->index.slots[slot] = entry;
+        h->count++;
+        lb->indexed = (int)h->count;
+    }
+    lb->entries[entry].gamesPlayed += games;
+    lb->entries[entry].wins += wins;
+    lb->entries[entry].losses += losses;
+    leaderboardPromote(lb, entry);
+    return 1;
+}
+
+// Folds any complete lines of highscores.txt past the recorded offset into the
+// leaderboard. On first run this imports the whole existing score log.
+// Call with LOCK_LEADERBOARD held exclusively, so each line is folded once
+// however many processes share the files.
+int leaderboardCatchUp(Leaderboard *lb) {
+    if (!leaderboardRefresh(lb)) return 0;
+    FILE *fp = fopen(HIGHSCORE_FILE, "r");
+    if (!fp) return 1; // no scores yet
+    if (fseek(fp, (long)lb->file.header->sourceOffset, SEEK_SET) != 0) {
+        fclose(fp);
+        return 0;
+    }
+    char line[MAX_LINE];
+    long offset = ftell(fp);
+    METRIC_TIMER_START(start);
+    while (fgets(line, sizeof(line), fp)) {
+        if (!strchr(line, '\n')) break; // partial line still being written
+        char name[MAX_NAME_LEN];
+        int games, wins, losses;
+        if (sscanf(line, "%49s %d %d %d", name, &games, &wins, &losses) == 4) {
+            if (!leaderboardRecord(lb, name, games, wins, losses)) break;
+            METRIC_ADD(COUNTER_SCORE_LINES_FOLDED, 1);
+        }
+        offset = ftell(fp);
+    }
+    lb->file.header->sourceOffset = (uint64_t)offset;
+    fclose(fp);
+    METRIC_TIMER_STOP(start, TIMER_LEADERBOARD_CATCH_UP);
+    return 1;
+}
+
+// SCOREBOARD
+
+void saveScoreToFile(Leaderboard *lb, GameSession *session) {
+    char line[MAX_LINE];
+    int len = snprintf(line, sizeof(line), "%s %d %d %d\n",
+                       session->playerName, session->roundsPlayed, session->wins, session->losses);
+    METRIC_TIMER_START(start);
+    if (!processLock(LOCK_LEADERBOARD, 1)) return;
+    int ok = durableWrite(HIGHSCORE_FILE, line, (size_t)len);
+    METRIC_TIMER_STOP(start, TIMER_SCORE_SAVE);
+    if (!ok) {
+        processUnlock(LOCK_LEADERBOARD);
+        printf("Error saving score.\n");
+        return;
+    }
+
+    // Folds in the line just written, plus anything other games added
+    ok = leaderboardCatchUp(lb);
+    processUnlock(LOCK_LEADERBOARD);
+    if (!ok) {
+        printf("Error updating leaderboard.\n");
+    }
+}
+
+// Writes the top list; returns 0 if there was nothing to show.
+int writeScoreboard(Leaderboard *lb, Output *out) {
+    // The top list may name entries other processes added
+    if (!processLock(LOCK_LEADERBOARD, 0)) return 0;
+    if (!leaderboardRefresh(lb)) {
+        processUnlock(LOCK_LEADERBOARD);
+        outPrintf(out, "Error: Could not reload %s.\n", LEADERBOARD_FILE);
+        return 0;
+    }
+    int count = (int)lb->topFile.header->count;
+    if (count == 0) {
+        processUnlock(LOCK_LEADERBOARD);
+        outPrintf(out, "No scores available yet.\n");
+        return 0;
+    }
+
+    METRIC_TIMER_START(start);
+    outPrintf(out, "%s  %s\n%s", DIVIDER, "Scoreboard", DIVIDER);
+    outPrintf(out, "%-20s | %-12s | %-6s | %-6s\n", "Player Name", "Games Played", "Wins", "Losses");
+    outPrintf(out, "%s", DIVIDER);
+    for (int i = 0; i < count; i++) {
+        ScoreEntry *e = &lb->entries[lb->top[i]];
+        outPrintf(out, "%-20s | %-12d | %-6d | %-6d\n",
+                  e->name,
+                  e->gamesPlayed,
+                  e->wins,
+                  e->losses);
+    }
+    outPrintf(out, "%s", DIVIDER);
+    outPrintf(out, "Showing top %d of %u players.\n", count, lb->file.header->count);
+    METRIC_TIMER_STOP(start, TIMER_SCOREBOARD_RENDER);
+    processUnlock(LOCK_LEADERBOARD);
+    return 1;
+}
+
+void displayScoreboard(Leaderboard *lb) {
+    writeScoreboard(lb, &console);
+    pauseProgram();
+}
+
+// GAME STATS LOGGING
+//
+// gamestats.bin is an append-only binary log: the 5-byte file header
+// (STATS_MAGIC, STATS_VERSION) followed by one record per game:
+//
+//   varint payload length | payload | CRC-32 of payload (4 bytes, little-endian)
+//
+// The payload is: varint timestamp, mode byte, varint rounds, varint wins,
+// varint name length, name bytes, then the player's and the computer's moves
+// packed 2 bits each (4 moves per byte, first round in the low bits).
+// Version 2 appends the seed of the game's Rng (8 bytes, little-endian) and a
+// flags byte (STATS_SEED_*); version 3 then adds the Rules.hash of the rules
+// the game was played under (4 bytes, little-endian). Readers take every
+// layout, so an older log simply carries on with version 3 records. Version 2
+// records predate rules.cfg and count as played under the built-in rules.
+
+uint32_t crc32(const unsigned char *data, size_t len) {
+    static uint32_t table[256];
+    if (!table[1]) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+    }
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < len; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+static unsigned char *putVarint(unsigned char *p, uint64_t v) {
+    while (v >= 0x80) {
+        *p++ = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (unsigned char)v;
+    return p;
+}
+
+// Returns the byte after the varint, or NULL if it runs past end.
+static const unsigned char *getVarint(const unsigned char *p, const unsigned char *end, uint64_t *v) {
+    *v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        unsigned char b = *p++;
+        *v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return p;
+    }
+    return NULL;
+}
+
+static unsigned char *packMoves(unsigned char *p, const uint8_t *moves, int count) {
+    int bytes = (count + 3) / 4;
+    memset(p, 0, (size_t)bytes);
+    for (int i = 0; i < count; i++) p[i / 4] |= (unsigned char)((moves[i] & 3) << ((i % 4) * 2));
+    return p + bytes;
+}
+
+static const unsigned char *unpackMoves(const unsigned char *p, uint8_t *moves, int count) {
+    for (int i = 0; i < count; i++) moves[i] = (p[i / 4] >> ((i % 4) * 2)) & 3;
+    return p + (count + 3) / 4;
+}
+
+// Encodes the whole game into one buffer and appends it with a single write.
+void saveGameStats(GameSession *session, int mode) {
+    uint8_t playerMoves[MAX_ROUNDS];
+    uint8_t compMoves[MAX_ROUNDS];
+    int rounds = session->roundsPlayed;
+    for (int i = 0; i < rounds; i++) {
+        playerMoves[i] = (uint8_t)(getHistoryMove(session->movesHistory, i) & 3);
+        compMoves[i] = (uint8_t)(getHistoryMove(session->compMovesHistory, i) & 3);
+    }
+
+    unsigned char payload[MAX_LOG_RECORD];
+    size_t nameLen = strlen(session->playerName);
+    unsigned char *p = payload;
+    p = putVarint(p, (uint64_t)time(NULL));
+    *p++ = (unsigned char)mode;
+    p = putVarint(p, (uint64_t)rounds);
+    p = putVarint(p, (uint64_t)session->wins);
+    p = putVarint(p, nameLen);
+    memcpy(p, session->playerName, nameLen);
+    p += nameLen;
+    p = packMoves(p, playerMoves, rounds);
+    p = packMoves(p, compMoves, rounds);
+    for (int i = 0; i < 8; i++) *p++ = (unsigned char)(session->seed >> (8 * i));
+    *p++ = (unsigned char)((session->engine == RNG_PCG ? STATS_SEED_PCG : 0) |
+                           (session->opponent == OPPONENT_ADAPTIVE ? STATS_SEED_ADAPTIVE : 0));
+    uint32_t rulesHash = gameRules()->hash;
+    for (int i = 0; i < 4; i++) *p++ = (unsigned char)(rulesHash >> (8 * i));
+    size_t payloadLen = (size_t)(p - payload);
+
+    unsigned char record[MAX_LOG_RECORD + 16];
+    unsigned char *r = record;
+    int fd = durableOpenAppend(STATS_FILE);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size == 0) {
+        // Only one process may write the file header
+        unsigned char header[5];
+        memcpy(header, STATS_MAGIC, 4);
+        header[4] = STATS_VERSION;
+        if (processLock(LOCK_STATS, 1)) {
+            if (fstat(fd, &st) == 0 && st.st_size == 0 && write(fd, header, sizeof(header)) != sizeof(header)) {
+                printf("Error saving game stats.\n");
+            }
+            processUnlock(LOCK_STATS);
+        }
+    }
+    r = putVarint(r, payloadLen);
+    memcpy(r, payload, payloadLen);
+    r += payloadLen;
+    uint32_t crc = crc32(payload, payloadLen);
+    for (int i = 0; i < 4; i++) *r++ = (unsigned char)(crc >> (8 * i));
+
+    METRIC_TIMER_START(start);
+    METRIC_ADD(COUNTER_BYTES_APPENDED, r - record);
+    if (write(fd, record, (size_t)(r - record)) != (ssize_t)(r - record)) {
+        printf("Error saving game stats.\n");
+    }
+    METRIC_TIMER_STOP(start, TIMER_STATS_SAVE);
+}
+
+// Keeps at least `need` unread bytes in the buffer if the file has them.
+static int logReaderFill(LogReader *reader, size_t need) {
+    if (reader->len - reader->pos >= need) return 1;
+    memmove(reader->buf, reader->buf + reader->pos, reader->len - reader->pos);
+    reader->bufStart += reader->pos;
+    reader->len -= reader->pos;
+    reader->pos = 0;
+    reader->len += fread(reader->buf + reader->len, 1, sizeof(reader->buf) - reader->len, reader->fp);
+    return reader->len >= need;
+}
+
+int logReaderOpen(LogReader *reader, const char *path) {
+    memset(reader, 0, sizeof(*reader));
+    reader->fp = fopen(path, "rb");
+    if (!reader->fp) return 0;
+    if (!logReaderFill(reader, 5) || memcmp(reader->buf, STATS_MAGIC, 4) != 0 ||
+        reader->buf[4] > STATS_VERSION) {
+        logReaderClose(reader);
+        return 0;
+    }
+    reader->pos = 5;
+    return 1;
+}
+
+// Continues reading at a record boundary previously returned by logReaderOffset.
+int logReaderSeek(LogReader *reader, uint64_t offset) {
+    if (offset < 5) offset = 5;
+    if (fseek(reader->fp, (long)offset, SEEK_SET) != 0) return 0;
+    reader->bufStart = offset;
+    reader->len = reader->pos = 0;
+    return 1;
+}
+
+// File offset of the next unread record
+uint64_t logReaderOffset(const LogReader *reader) {
+    return reader->bufStart + reader->pos;
+}
+
+static int decodeRecord(const unsigned char *p, const unsigned char *end, LogRecord *rec) {
+    uint64_t timestamp, rounds, wins, nameLen;
+    memset(rec, 0, sizeof(*rec));
+    if (!(p = getVarint(p, end, &timestamp)) || p >= end) return 0;
+    rec->mode = *p++;
+    if (rec->mode != 1 && rec->mode != 2) return 0;
+    if (!(p = getVarint(p, end, &rounds)) || !(p = getVarint(p, end, &wins)) ||
+        !(p = getVarint(p, end, &nameLen))) return 0;
+    if (rounds > MAX_ROUNDS || wins > rounds || nameLen >= MAX_NAME_LEN) return 0;
+    size_t v1Len = nameLen + 2 * ((rounds + 3) / 4);
+    size_t left = (size_t)(end - p);
+    if (left != v1Len && left != v1Len + 9 && left != v1Len + 13) return 0;
+    memcpy(rec->playerName, p, nameLen);
+    p += nameLen;
+    rec->timestamp = (int64_t)timestamp;
+    rec->rounds = (int)rounds;
+    rec->wins = (int)wins;
+    rec->losses = (int)(rounds - wins);
+    p = unpackMoves(p, rec->playerMoves, rec->rounds);
+    p = unpackMoves(p, rec->compMoves, rec->rounds);
+    if (p < end) {
+        for (int i = 0; i < 8; i++) rec->seed |= (uint64_t)p[i] << (8 * i);
+        rec->engine = (p[8] & STATS_SEED_PCG) ? RNG_PCG : RNG_XOSHIRO;
+        rec->opponent = (p[8] & STATS_SEED_ADAPTIVE) ? OPPONENT_ADAPTIVE : OPPONENT_RANDOM;
+        rec->seeded = 1;
+        gameRules();
+        rec->rulesHash = builtinRulesHash;
+        p += 9;
+        if (p < end) {
+            rec->rulesHash = (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+        }
+    }
+    return 1;
+}
+
+// Returns 1 with the next intact record, or 0 at the end of the log (a torn
+// final record counts as the end). Records failing their CRC are skipped.
+int logReaderNext(LogReader *reader, LogRecord *rec) {
+    while (logReaderFill(reader, 1)) {
+        uint64_t payloadLen;
+        logReaderFill(reader, 10);
+        const unsigned char *start = reader->buf + reader->pos;
+        const unsigned char *p = getVarint(start, reader->buf + reader->len, &payloadLen);
+        if (!p || payloadLen > MAX_LOG_RECORD) return 0;
+        size_t headerLen = (size_t)(p - start);
+        if (!logReaderFill(reader, headerLen + payloadLen + 4)) return 0;
+
+        const unsigned char *payload = reader->buf + reader->pos + headerLen;
+        const unsigned char *c = payload + payloadLen;
+        uint32_t stored = (uint32_t)c[0] | (uint32_t)c[1] << 8 | (uint32_t)c[2] << 16 | (uint32_t)c[3] << 24;
+        reader->pos += headerLen + payloadLen + 4;
+        if (stored == crc32(payload, payloadLen) && decodeRecord(payload, payload + payloadLen, rec)) {
+            return 1;
+        }
+        reader->corrupt++;
+    }
+    return 0;
+}
+
+void logReaderClose(LogReader *reader) {
+    if (reader->fp) fclose(reader->fp);
+    reader->fp = NULL;
+}
+
+// Games recorded before the binary log only exist as text in gamestats.txt.
+// They carry no moves or seeds, so they are shown as they are rather than
+// imported into the log, where analytics and replays would trust them.
+static int showLegacyStats(void) {
+    FILE *fp = fopen(LEGACY_STATS_FILE, "r");
+    if (!fp) return 0;
+    char line[MAX_LINE];
+    int shown = 0;
+    while (fgets(line, MAX_LINE, fp)) {
+        if (!shown) printHeader("Game Stats History (before binary log)");
+        printf("%s", line);
+        shown = 1;
+    }
+    if (shown) printFooter();
+    fclose(fp);
+    return shown;
+}
+
+void viewGameStats() {
+    int legacy = showLegacyStats();
+    LogReader *reader = malloc(sizeof(LogReader));
+    if (!reader || !logReaderOpen(reader, STATS_FILE)) {
+        if (!legacy) printf("No game stats recorded yet.\n");
+        free(reader);
+        pauseProgram();
+        return;
+    }
+    printHeader("Game Stats History");
+    LogRecord rec;
+    while (logReaderNext(reader, &rec)) {
+        char when[32];
+        time_t t = (time_t)rec.timestamp;
+        strftime(when, sizeof(when), "%Y-%m-%d %H:%M", localtime(&t));
+        printf("Player: %s | Mode: %s | Rounds: %d | Wins: %d | Losses: %d | %s\n",
+               rec.playerName,
+               modeName(rec.mode),
+               rec.rounds,
+               rec.wins,
+               rec.losses,
+               when);
+        printf("Moves (Player vs Computer):");
+        for (int i = 0; i < rec.rounds; i++) {
+            printf(" %s-%s",
+                   moveToString(pickMove(rec.mode, rec.playerMoves[i])),
+                   moveToString(pickMove(rec.mode, rec.compMoves[i])));
+        }
+        if (rec.seeded) {
+            printf("\nSeed: %llu (%s opponent)", (unsigned long long)rec.seed,
+                   rec.opponent == OPPONENT_ADAPTIVE ? "adaptive" : "random");
+        }
+        printf("\n-----\n");
+    }
+    if (reader->corrupt > 0) {
+        printf("Skipped %ld damaged record(s).\n", reader->corrupt);
+    }
+    printFooter();
+    logReaderClose(reader);
+    free(reader);
+    pauseProgram();
+}
+
+// TIMERS
+//
+// Everything that waits uses the monotonic clock, so wall-clock changes never
+// stretch or cut short a delay, and every wait sleeps instead of spinning.
+
+static double monotonicSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+uint64_t monotonicMillis(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+// Sleeps until ms have passed, resuming after signals against a fixed deadline.
+void sleepMillis(uint64_t ms) {
+    uint64_t deadline = monotonicMillis() + ms;
+    uint64_t now;
+    while ((now = monotonicMillis()) < deadline) {
+        uint64_t left = deadline - now;
+        struct timespec ts = {(time_t)(left / 1000), (long)(left % 1000) * 1000000};
+        nanosleep(&ts, NULL);
+    }
+}
+
+void timerWheelInit(TimerWheel *wheel, uint64_t now) {
+    for (int i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+        wheel->slots[i].next = wheel->slots[i].prev = &wheel->slots[i];
+    }
+    wheel->tick = now / TIMER_TICK_MS;
+    wheel->count = 0;
+}
+
+static void timerLink(Timer *head, Timer *timer) {
+    timer->next = head;
+    timer->prev = head->prev;
+    head->prev->next = timer;
+    head->prev = timer;
+}
+
+static void timerUnlink(Timer *timer) {
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->next = timer->prev = NULL;
+}
+
+// (Re)arms timer to fire at `expires`. Already-due times fire on the next advance.
+void timerSchedule(TimerWheel *wheel, Timer *timer, uint64_t expires) {
+    if (timer->next) {
+        timerUnlink(timer);
+        wheel->count--;
+    }
+    uint64_t tick = expires / TIMER_TICK_MS;
+    if (tick < wheel->tick) tick = wheel->tick;
+    timer->expires = expires;
+    timerLink(&wheel->slots[tick & (TIMER_WHEEL_SLOTS - 1)], timer);
+    wheel->count++;
+}
+
+void timerCancel(TimerWheel *wheel, Timer *timer) {
+    if (!timer->next) return;
+    timerUnlink(timer);
+    wheel->count--;
+}
+
+// Fires every timer due by `now`. The callback may schedule, cancel or free
+// any timer, including the one it was given, which is unlinked beforehand.
+void timerWheelAdvance(TimerWheel *wheel, uint64_t now, TimerFn fire, void *ctx) {
+    uint64_t nowTick = now / TIMER_TICK_MS;
+    for (int steps = 0; wheel->tick <= nowTick && steps < TIMER_WHEEL_SLOTS; steps++) {
+        Timer *head = &wheel->slots[wheel->tick & (TIMER_WHEEL_SLOTS - 1)];
+        wheel->tick++; // timers re-armed for "now" from a callback land in the next slot
+
+        // Detach the slot so callbacks cannot change what this pass walks
+        Timer pending;
+        if (head->next == head) continue;
+        pending.next = head->next;
+        pending.prev = head->prev;
+        pending.next->prev = &pending;
+        pending.prev->next = &pending;
+        head->next = head->prev = head;
+
+        while (pending.next != &pending) {
+            Timer *timer = pending.next;
+            timerUnlink(timer);
+            if (timer->expires / TIMER_TICK_MS > nowTick) {
+                timerLink(head, timer); // due on a later turn of the wheel
+                continue;
+            }
+            wheel->count--;
+            fire(timer, ctx);
+        }
+    }
+    if (wheel->tick <= nowTick) wheel->tick = nowTick + 1; // a full turn covers every slot
+}
+
+// Milliseconds until the earliest occupied slot comes due, 0 if one already
+// is, or -1 when nothing is scheduled (wait forever).
+int timerWheelNextDelay(const TimerWheel *wheel, uint64_t now) {
+    if (wheel->count == 0) return -1;
+    for (uint64_t tick = wheel->tick; tick < wheel->tick + TIMER_WHEEL_SLOTS; tick++) {
+        const Timer *head = &wheel->slots[tick & (TIMER_WHEEL_SLOTS - 1)];
+        if (head->next == head) continue;
+        uint64_t at = tick * TIMER_TICK_MS;
+        return at > now ? (int)(at - now) : 0;
+    }
+    return -1;
+}
+
+// PLAYER ANALYTICS
+//
+// analytics.dat caches per-player aggregates of gamestats.bin. Opening it
+// folds in only the sessions appended since the last time, so a report is a
+// hash lookup rather than a rescan of the whole history.
+
+static void refreshAnalyticsPointers(Analytics *an) {
+    an->players = mapRecords(&an->file);
+    an->index.base = (const char *)an->players;
+}
+
+int openAnalytics(Analytics *an) {
+    memset(an, 0, sizeof(*an));
+    an->index.stride = sizeof(PlayerAnalytics);
+    if (!mapOpen(&an->file, ANALYTICS_FILE, ANALYTICS_MAGIC, ANALYTICS_VERSION, sizeof(PlayerAnalytics))) {
+        return 0;
+    }
+    refreshAnalyticsPointers(an);
+    return analyticsCatchUp(an) >= 0;
+}
+
+void closeAnalytics(Analytics *an) {
+    if (an->file.base) msync(an->file.base, an->file.mapSize, MS_ASYNC);
+    mapClose(&an->file);
+    free(an->index.slots);
+    memset(an, 0, sizeof(*an));
+}
+
+static PlayerAnalytics *analyticsEntry(Analytics *an, const char *name) {
+    FileHeader *h = an->file.header;
+    int count = (int)h->count;
+    if (!ensureIndex(&an->index, count, count + 1)) return NULL;
+    int slot = indexSlot(&an->index, name);
+    int entry = an->index.slots[slot];
+    if (entry == -1) {
+        if (!mapReserve(&an->file, (uint32_t)count + 1)) return NULL;
+        refreshAnalyticsPointers(an);
+        entry = count;
+        memset(&an->players[entry], 0, sizeof(PlayerAnalytics));
+        snprintf(an->players[entry].name, sizeof(an->players[entry].name), "%s", name);
+        an->index.slots[slot] = entry;
+        an->file.header->count++;
+    }
+    return &an->players[entry];
+}
+
+static int analyticsRecord(Analytics *an, const LogRecord *rec) {
+    PlayerAnalytics *pa = analyticsEntry(an, rec->playerName);
+    if (!pa) return 0;
+    int m = rec->mode - 1;
+    int won = rec->wins > rec->losses;
+    pa->games++;
+    pa->gamesWon += (uint32_t)won;
+    pa->currentStreak = won ? pa->currentStreak + 1 : 0;
+    if (pa->currentStreak > pa->longestStreak) pa->longestStreak = pa->currentStreak;
+    pa->rounds[m] += (uint32_t)rec->rounds;
+    pa->roundsWon[m] += (uint32_t)rec->wins;
+    for (int i = 0; i < rec->rounds; i++) pa->moves[m][rec->playerMoves[i]][rec->compMoves[i]]++;
+
+    time_t t = (time_t)rec->timestamp;
+    struct tm tm;
+    int32_t key = localtime_r(&t, &tm) ? (tm.tm_year + 1900) * 12 + tm.tm_mon : 0;
+    if (key == 0) return 1; // no month to count it in; 0 marks an empty slot
+    int slot = key % ANALYTICS_MONTHS;
+    if (pa->monthKey[slot] < key) { // a new month replaces the one a year older
+        pa->monthKey[slot] = key;
+        pa->monthGames[slot] = 0;
+        pa->monthWon[slot] = 0;
+    }
+    if (pa->monthKey[slot] == key) {
+        pa->monthGames[slot]++;
+        pa->monthWon[slot] += (uint32_t)won;
+    }
+    return 1;
+}
+
+// Folds every complete session past the recorded offset into the cache.
+// Returns how many were added, or -1 on error. If the log has been replaced
+// by a shorter one, the cache is rebuilt from scratch.
+long analyticsCatchUp(Analytics *an) {
+    FileHeader *h = an->file.header;
+    struct stat st;
+    if (stat(STATS_FILE, &st) != 0) return 0; // nothing logged yet
+    if ((uint64_t)st.st_size < h->sourceOffset) {
+        h->count = 0;
+        h->sourceOffset = 0;
+        free(an->index.slots);
+        memset(&an->index, 0, sizeof(an->index));
+        an->index.stride = sizeof(PlayerAnalytics);
+        refreshAnalyticsPointers(an);
+    }
+
+    LogReader *reader = malloc(sizeof(LogReader));
+    if (!reader) return -1;
+    if (!logReaderOpen(reader, STATS_FILE)) {
+        free(reader);
+        return 0;
+    }
+    long added = 0;
+    LogRecord rec;
+    METRIC_TIMER_START(start);
+    if (logReaderSeek(reader, h->sourceOffset)) {
+        while (logReaderNext(reader, &rec)) {
+            if (!analyticsRecord(an, &rec)) {
+                added = -1;
+                break;
+            }
+            an->file.header->sourceOffset = logReaderOffset(reader);
+            added++;
+        }
+    }
+    METRIC_TIMER_STOP(start, TIMER_ANALYTICS_REFRESH);
+    METRIC_ADD(COUNTER_LOG_RECORDS_FOLDED, added > 0 ? added : 0);
+    logReaderClose(reader);
+    free(reader);
+    return added;
+}
+
+const PlayerAnalytics *analyticsFind(Analytics *an, const char *name) {
+    int count = (int)an->file.header->count;
+    if (count == 0 || !ensureIndex(&an->index, count, count)) return NULL;
+    int entry = an->index.slots[indexSlot(&an->index, name)];
+    return entry == -1 ? NULL : &an->players[entry];
+}
+
+static double percent(uint32_t part, uint32_t whole) {
+    return whole ? 100.0 * part / whole : 0.0;
+}
+
+void showPlayerAnalytics(const PlayerAnalytics *pa) {
+    char title[MAX_LINE];
+    snprintf(title, sizeof(title), "Analytics for %s", pa->name);
+    printHeader(title);
+    printf("Games: %u | Won: %u (%.1f%%)\n", pa->games, pa->gamesWon, percent(pa->gamesWon, pa->games));
+    printf("Longest win streak: %u | Current streak: %u\n", pa->longestStreak, pa->currentStreak);
+
+    for (int m = 0; m < 2; m++) {
+        if (pa->rounds[m] == 0) continue;
+        int mode = m + 1;
+        int count = moveCount(mode);
+        printf("\n%s mode: %u rounds, %.1f%% won\n", modeName(mode),
+               pa->rounds[m], percent(pa->roundsWon[m], pa->rounds[m]));
+        printf("Your moves:");
+        for (int i = 0; i < count; i++) {
+            uint32_t played = 0;
+            for (int j = 0; j < count; j++) played += pa->moves[m][i][j];
+            printf("  %s %.1f%%", moveToString(pickMove(mode, i)), percent(played, pa->rounds[m]));
+        }
+        printf("\nHead-to-head (rows: your move, columns: computer's move):\n     ");
+        for (int j = 0; j < count; j++) printf("%8s", moveToString(pickMove(mode, j)));
+        printf("\n");
+        for (int i = 0; i < count; i++) {
+            printf("  %-3s", moveToString(pickMove(mode, i)));
+            for (int j = 0; j < count; j++) printf("%8u", pa->moves[m][i][j]);
+            printf("\n");
+        }
+    }
+
+    // Months oldest first; the buckets are few, so a selection pass is enough
+    printf("\nGames won by month:\n");
+    int32_t last = 0;
+    while (1) {
+        int next = -1;
+        for (int i = 0; i < ANALYTICS_MONTHS; i++) {
+            if (pa->monthKey[i] > last && (next == -1 || pa->monthKey[i] < pa->monthKey[next])) next = i;
+        }
+        if (next == -1) break;
+        last = pa->monthKey[next];
+        printf("  %04d-%02d: %u games, %.1f%% won\n", last / 12, last % 12 + 1,
+               pa->monthGames[next], percent(pa->monthWon[next], pa->monthGames[next]));
+    }
+    printFooter();
+}
+
+void showAnalyticsSummary(const Analytics *an) {
+    uint32_t count = an->file.header->count;
+    printHeader("Player Analytics");
+    printf("%-20s | %-6s | %-7s | %-12s | %s\n", "Player Name", "Games", "Won %", "Rounds won %", "Best Streak");
+    for (uint32_t i = 0; i < count; i++) {
+        const PlayerAnalytics *pa = &an->players[i];
+        uint32_t rounds = pa->rounds[0] + pa->rounds[1];
+        printf("%-20s | %-6u | %6.1f%% | %11.1f%% | %u\n", pa->name, pa->games,
+               percent(pa->gamesWon, pa->games),
+               percent(pa->roundsWon[0] + pa->roundsWon[1], rounds), pa->longestStreak);
+    }
+    printf("%u player(s).\n", count);
+    printFooter();
+}
+
+// Brings the cache up to date and prints one player's report, or the summary
+// of every player when name is NULL.
+int runAnalytics(const char *name) {
+    Analytics an;
+    double start = monotonicSeconds();
+    // Held until the report is printed, so no other process folds in the
+    // same sessions or grows the cache under this one
+    if (!processLock(LOCK_ANALYTICS, 1)) return 0;
+    if (!openAnalytics(&an)) {
+        processUnlock(LOCK_ANALYTICS);
+        printf("Error: Could not open %s.\n", ANALYTICS_FILE);
+        return 0;
+    }
+    double refreshed = monotonicSeconds();
+    int ok = 1;
+    if (!name) {
+        showAnalyticsSummary(&an);
+    } else {
+        const PlayerAnalytics *pa = analyticsFind(&an, name);
+        if (pa) {
+            showPlayerAnalytics(pa);
+        } else {
+            printf("No games recorded for %s.\n", name);
+            ok = 0;
+        }
+    }
+    printf("Cache refreshed in %.2f ms, report in %.2f ms.\n",
+           (refreshed - start) * 1000, (monotonicSeconds() - refreshed) * 1000);
+    closeAnalytics(&an);
+    processUnlock(LOCK_ANALYTICS);
+    return ok;
+}
+
+void viewPlayerAnalytics() {
+    char name[MAX_NAME_LEN];
+    printf("Enter player name (blank for all players): ");
+    readLine(name, MAX_NAME_LEN);
+    runAnalytics(name[0] ? name : NULL);
+    pauseProgram();
+}
+
+// BATCH SIMULATION
+
+// Types the move the way a player would: its alias if it has one
+static const char *strategyInput(int mode, int choice) {
+    return gameRules()->modes[mode - 1].inputs[choice % moveCount(mode)];
+}
+
+static const char *randomStrategy(int mode, int round, Rng *rng) {
+    (void)round;
+    return strategyInput(mode, (int)rngBounded(rng, (uint32_t)moveCount(mode)));
+}
+
+static const char *fixedStrategy(int mode, int round, Rng *rng) {
+    (void)round;
+    (void)rng;
+    return strategyInput(mode, 0);
+}
+
+static const char *cycleStrategy(int mode, int round, Rng *rng) {
+    (void)rng;
+    return strategyInput(mode, round % moveCount(mode));
+}
+
+static const Strategy strategies[] = {
+    {"random", randomStrategy},
+    {"fixed", fixedStrategy},
+    {"cycle", cycleStrategy},
+};
+
+const Strategy *findStrategy(const char *name) {
+    for (size_t i = 0; i < sizeof(strategies) / sizeof(strategies[0]); i++) {
+        if (strcmp(strategies[i].name, name) == 0) return &strategies[i];
+    }
+    return NULL;
+}
+
+// Thread entry point: plays job->games complete games through the same
+// validation and scoring core as playGame, with no I/O.
+void *simulateGames(void *arg) {
+    SimJob *job = (SimJob *)arg;
+    uint8_t compChoices[MAX_ROUNDS];
+    for (long g = 0; g < job->games; g++) {
+        int wins = 0;
+        uint64_t history = 0;
+        if (moveCount(job->mode) == 4) {
+            rngFillMoves(&job->rng, compChoices, job->rounds);
+        } else {
+            for (int r = 0; r < job->rounds; r++) {
+                compChoices[r] = (uint8_t)rngBounded(&job->rng, (uint32_t)moveCount(job->mode));
+            }
+        }
+        for (int r = 0; r < job->rounds; r++) {
+            const char *input = job->strategy->nextInput(job->mode, r, &job->rng);
+            Move playerMove = parseMove(input, job->mode);
+            if (playerMove == MOVE_NONE) continue;
+            Move compMove = pickMove(job->mode, compChoices[r]);
+            if (job->opponent == OPPONENT_ADAPTIVE) {
+                compMove = opponentMove(&job->model, &job->rng, job->mode, history, r);
+                modelLearn(&job->model, job->mode, history, r, playerMove);
+                setHistoryMove(&history, r, playerMove);
+            }
+            wins += scoreRound(playerMove, compMove);
+        }
+        int losses = job->rounds - wins;
+        job->compRoundWins += losses;
+        job->roundWins[wins]++;
+        if (wins > losses) {
+            job->wonGames++;
+        } else if (wins < losses) {
+            job->lostGames++;
+        } else {
+            job->drawnGames++;
+        }
+    }
+    return NULL;
+}
+
+// Runs games across threads, merging per-thread results into *total.
+// Returns the elapsed seconds, or -1 on failure.
+static double simulate(const Rng *rng, OpponentKind opponent, const Strategy *strategy, int mode,
+                       int rounds, long games, int threads, SimJob *total) {
+    SimJob *jobs = calloc((size_t)threads, sizeof(SimJob));
+    pthread_t *tids = calloc((size_t)threads, sizeof(pthread_t));
+    if (!jobs || !tids) {
+        free(jobs);
+        free(tids);
+        return -1;
+    }
+
+    double start = monotonicSeconds();
+    for (int t = 0; t < threads; t++) {
+        jobs[t].strategy = strategy;
+        jobs[t].mode = mode;
+        jobs[t].rounds = rounds;
+        jobs[t].games = games / threads + (t < games % threads ? 1 : 0);
+        jobs[t].opponent = opponent;
+        rngSplit(&jobs[t].rng, rng, t);
+        pthread_create(&tids[t], NULL, simulateGames, &jobs[t]);
+    }
+
+    memset(total, 0, sizeof(*total));
+    for (int t = 0; t < threads; t++) {
+        pthread_join(tids[t], NULL);
+        total->wonGames += jobs[t].wonGames;
+        total->lostGames += jobs[t].lostGames;
+        total->drawnGames += jobs[t].drawnGames;
+        total->compRoundWins += jobs[t].compRoundWins;
+        for (int w = 0; w <= rounds; w++) total->roundWins[w] += jobs[t].roundWins[w];
+    }
+    double elapsed = monotonicSeconds() - start;
+
+    free(jobs);
+    free(tids);
+    return elapsed;
+}
+
+int runSimulation(const Rng *rng, OpponentKind opponent, const char *strategyName, int mode, int rounds,
+                  long games, int threads) {
+    const Strategy *strategy = findStrategy(strategyName);
+    if (!strategy) {
+        printf("Unknown strategy '%s'.\n", strategyName);
+        return 0;
+    }
+    if (rounds < 1 || rounds > MAX_ROUNDS || games < 1) {
+        printf("Rounds must be 1-%d and games at least 1.\n", MAX_ROUNDS);
+        return 0;
+    }
+    if (threads < 1) threads = 1;
+    if (threads > MAX_SIM_THREADS) threads = MAX_SIM_THREADS;
+    if (threads > games) threads = (int)games;
+
+    SimJob total;
+    double elapsed = simulate(rng, opponent, strategy, mode, rounds, games, threads, &total);
+    if (elapsed < 0) return 0;
+
+    printHeader("Simulation Results");
+    printf("Strategy: %s | Opponent: %s | Mode: %s | Rounds: %d | Threads: %d\n",
+           strategy->name, opponent == OPPONENT_ADAPTIVE ? "adaptive" : "random",
+           modeName(mode), rounds, threads);
+    printf("Games: %ld  Won: %ld (%.2f%%)  Lost: %ld (%.2f%%)  Drawn: %ld (%.2f%%)\n",
+           games,
+           total.wonGames, 100.0 * total.wonGames / games,
+           total.lostGames, 100.0 * total.lostGames / games,
+           total.drawnGames, 100.0 * total.drawnGames / games);
+    printDivider();
+    printf("%-10s | %-12s | %s\n", "Round wins", "Games", "Share");
+    for (int w = 0; w <= rounds; w++) {
+        printf("%-10d | %-12ld | %6.2f%%\n", w, total.roundWins[w], 100.0 * total.roundWins[w] / games);
+    }
+    printDivider();
+    printf("Elapsed: %.3f s  (%.0f games/sec)\n", elapsed, elapsed > 0 ? games / elapsed : 0.0);
+    printFooter();
+    return 1;
+}
+
+// Measures adaptive prediction latency, then the computer's round win rate
+// against every scripted strategy with each opponent.
+int benchmarkOpponent(const Rng *rng, long games) {
+    const long predictions = 10000000;
+    Rng local = *rng;
+    OpponentModel model;
+    memset(&model, 0, sizeof(model));
+    uint64_t history = 0;
+    for (int r = 0; r < MAX_ROUNDS; r++) {
+        Move m = computerMove(&local, 1);
+        modelLearn(&model, 1, history, r, m);
+        setHistoryMove(&history, r, m);
+    }
+    volatile int sink = 0;
+    double start = monotonicSeconds();
+    for (long i = 0; i < predictions; i++) {
+        sink += opponentMove(&model, &local, 1, history, 2 + (int)(i & 15));
+    }
+    double elapsed = monotonicSeconds() - start;
+    (void)sink;
+
+    printHeader("Adaptive Opponent Benchmark");
+    printf("Prediction latency: %.1f ns (%ld predictions)\n", elapsed * 1e9 / predictions, predictions);
+    printDivider();
+    printf("%-10s | %-8s | %-16s | %s\n", "Strategy", "Mode", "Random computer", "Adaptive computer");
+    for (size_t s = 0; s < sizeof(strategies) / sizeof(strategies[0]); s++) {
+        for (int mode = 1; mode <= 2; mode++) {
+            double rate[2];
+            for (int o = 0; o < 2; o++) {
+                SimJob total;
+                if (simulate(rng, (OpponentKind)o, &strategies[s], mode, 10, games, 1, &total) < 0) return 0;
+                rate[o] = 100.0 * total.compRoundWins / (games * 10.0);
+            }
+            printf("%-10s | %-8s | %15.2f%% | %16.2f%%\n", strategies[s].name,
+                   modeName(mode), rate[0], rate[1]);
+        }
+    }
+    printFooter();
+    return 1;
+}
+
+// TOURNAMENT
+//
+// Entrants are either every stored profile or N generated bots. A match is
+// two games of `rounds` rounds: each side takes one turn as the runner, who
+// wins a round when the moves differ (the player's side in a normal game),
+// while the other side chases. The side with more rounds won takes the match;
+// a tie is settled by a coin flip. Every match seeds its own Rng from the
+// pairing, so results do not depend on which thread plays it.
+
+typedef struct {
+    pthread_t tid;
+    TaskPool *pool;
+    int id;
+} PoolWorker;
+
+// Takes the next task from the worker's own range, or steals half of the
+// largest remaining range. Returns -1 when all work is gone.
+static long poolTake(TaskPool *pool, int self) {
+    WorkRange *own = &pool->ranges[self];
+    while (1) {
+        pthread_mutex_lock(&own->lock);
+        if (own->next < own->end) {
+            long task = own->next++;
+            pthread_mutex_unlock(&own->lock);
+            return task;
+        }
+        pthread_mutex_unlock(&own->lock);
+
+        int victim = -1;
+        long most = 0;
+        for (int i = 1; i < pool->workers; i++) {
+            int v = (self + i) % pool->workers;
+            long left = pool->ranges[v].end - pool->ranges[v].next; // unlocked peek is only a hint
+            if (left > most) {
+                most = left;
+                victim = v;
+            }
+        }
+        if (victim == -1) return -1;
+
+        WorkRange *from = &pool->ranges[victim];
+        pthread_mutex_lock(&from->lock);
+        long left = from->end - from->next;
+        long start = 0;
+        long end = 0;
+        if (left > 0) {
+            end = from->end;
+            start = end - (left + 1) / 2;
+            from->end = start;
+        }
+        pthread_mutex_unlock(&from->lock);
+        if (start == end) continue; // lost the race; look again
+
+        pthread_mutex_lock(&own->lock);
+        own->next = start;
+        own->end = end;
+        pthread_mutex_unlock(&own->lock);
+    }
+}
+
+static void *poolWorker(void *arg) {
+    PoolWorker *w = arg;
+    long task;
+    while ((task = poolTake(w->pool, w->id)) != -1) w->pool->run(w->pool->ctx, task, w->id);
+    return NULL;
+}
+
+// Runs run(ctx, task, worker) for every task in [0, tasks) and returns when
+// all are done. Worker ids are 0..threads-1 so callers can keep per-worker
+// results without locking.
+int poolRun(long tasks, int threads, TaskFn run, void *ctx) {
+    TaskPool pool = {calloc((size_t)threads, sizeof(WorkRange)), threads, run, ctx};
+    PoolWorker *workers = calloc((size_t)threads, sizeof(PoolWorker));
+    if (!pool.ranges || !workers) {
+        free(pool.ranges);
+        free(workers);
+        return 0;
+    }
+    for (int t = 0; t < threads; t++) {
+        pthread_mutex_init(&pool.ranges[t].lock, NULL);
+        pool.ranges[t].next = tasks * t / threads;
+        pool.ranges[t].end = tasks * (t + 1) / threads;
+        workers[t].pool = &pool;
+        workers[t].id = t;
+    }
+    for (int t = 1; t < threads; t++) pthread_create(&workers[t].tid, NULL, poolWorker, &workers[t]);
+    poolWorker(&workers[0]); // the calling thread is worker 0
+    for (int t = 1; t < threads; t++) pthread_join(workers[t].tid, NULL);
+    for (int t = 0; t < threads; t++) pthread_mutex_destroy(&pool.ranges[t].lock);
+    free(pool.ranges);
+    free(workers);
+    return 1;
+}
+
+typedef struct {
+    const Entrant *entrants;
+    int count;
+    int mode;
+    int rounds;
+    Rng rng;                    // base state; matches seed their own from it
+    EntrantResult *results;     // per worker: results[worker * count + entrant]
+    const int *field;           // knockout: this round's entrants, in pairs
+    int *winners;               // knockout: winner of each pair
+} Tournament;
+
+// One side of a match in progress
+typedef struct {
+    const Entrant *entrant;
+    uint64_t own;           // this side's moves this game
+    uint64_t seen;          // the other side's moves this game
+    OpponentModel learned;  // ENTRANT_ADAPTIVE: the other side's habits
+} MatchSide;
+
+static Move entrantMove(MatchSide *side, Rng *rng, int mode, int round, int chasing) {
+    const Entrant *e = side->entrant;
+    if (e->kind == ENTRANT_PROFILE) {
+        return predictMove(&e->model, rng, mode, side->own, round); // its own most likely move
+    }
+    if (e->kind == ENTRANT_ADAPTIVE) {
+        const ModeRules *m = &gameRules()->modes[mode - 1];
+        Move guess = predictMove(&side->learned, rng, mode, side->seen, round);
+        if (chasing) return pickMove(mode, m->counter[guess & 3]);
+        // Running: any move that beats the guess, counted on from the guess
+        int options[RULES_MAX_MOVES];
+        int n = 0;
+        for (int k = 1; k <= m->moveCount; k++) {
+            int move = ((guess & 3) + k) % m->moveCount;
+            if (m->beats[move] >> (guess & 3) & 1) options[n++] = move;
+        }
+        if (n == 0) return guess;
+        return pickMove(mode, n == 1 ? options[0] : options[rngBounded(rng, (uint32_t)n)]);
+    }
+    Move m = parseMove(e->strategy->nextInput(mode, round, rng), mode);
+    return pickMove(mode, ((m & 3) + e->offset) % moveCount(mode));
+}
+
+// Plays entrant a against entrant b and returns the winner's index.
+static int playMatch(const Tournament *t, int a, int b, int *wonA, int *wonB) {
+    Rng rng;
+    rngSeed(&rng, t->rng.engine, t->rng.s[0] ^ ((uint64_t)a * (uint64_t)t->count + (uint64_t)b + 1) * 0x9E3779B97F4A7C15ull);
+    MatchSide sides[2];
+    memset(sides, 0, sizeof(sides));
+    sides[0].entrant = &t->entrants[a];
+    sides[1].entrant = &t->entrants[b];
+    int won[2] = {0, 0};
+    for (int runner = 0; runner < 2; runner++) {
+        int chaser = 1 - runner;
+        sides[0].own = sides[0].seen = sides[1].own = sides[1].seen = 0;
+        for (int r = 0; r < t->rounds; r++) {
+            Move moves[2];
+            moves[runner] = entrantMove(&sides[runner], &rng, t->mode, r, 0);
+            moves[chaser] = entrantMove(&sides[chaser], &rng, t->mode, r, 1);
+            won[scoreRound(moves[runner], moves[chaser]) ? runner : chaser]++;
+            for (int s = 0; s < 2; s++) {
+                if (sides[s].entrant->kind == ENTRANT_ADAPTIVE) {
+                    modelLearn(&sides[s].learned, t->mode, sides[s].seen, r, moves[1 - s]);
+                }
+                setHistoryMove(&sides[s].own, r, moves[s]);
+                setHistoryMove(&sides[s].seen, r, moves[1 - s]);
+            }
+        }
+    }
+    *wonA = won[0];
+    *wonB = won[1];
+    if (won[0] != won[1]) return won[0] > won[1] ? a : b;
+    return rngBounded(&rng, 2) ? b : a;
+}
+
+static void recordMatch(const Tournament *t, int worker, int a, int b, int wonA, int wonB, int winner) {
+    EntrantResult *res = &t->results[(size_t)worker * (size_t)t->count];
+    res[a].matches++;
+    res[b].matches++;
+    res[winner].matchWins++;
+    res[a].rounds += wonA + wonB;
+    res[b].rounds += wonA + wonB;
+    res[a].roundWins += wonA;
+    res[b].roundWins += wonB;
+    res[winner].wonRounds += wonA + wonB;
+    res[winner].wonRoundWins += winner == a ? wonA : wonB;
+}
+
+// Round robin: task i plays entrant i against every later entrant.
+static void roundRobinTask(void *ctx, long task, int worker) {
+    const Tournament *t = ctx;
+    int a = (int)task;
+    for (int b = a + 1; b < t->count; b++) {
+        int wonA, wonB;
+        int winner = playMatch(t, a, b, &wonA, &wonB);
+        recordMatch(t, worker, a, b, wonA, wonB, winner);
+    }
+}
+
+// Knockout: task i plays the i-th pair of the current field.
+static void knockoutTask(void *ctx, long task, int worker) {
+    const Tournament *t = ctx;
+    int a = t->field[2 * task];
+    int b = t->field[2 * task + 1];
+    int wonA, wonB;
+    int winner = playMatch(t, a, b, &wonA, &wonB);
+    recordMatch(t, worker, a, b, wonA, wonB, winner);
+    t->winners[task] = winner;
+}
+
+static Entrant *makeEntrants(ProfileStore *store, int bots, int *count) {
+    int n = bots > 0 ? bots : store->count;
+    Entrant *entrants = calloc((size_t)(n > 0 ? n : 1), sizeof(Entrant));
+    if (!entrants) return NULL;
+    static const char *kindNames[4] = {"random", "fixed", "cycle", "adaptive"};
+    for (int i = 0; i < n; i++) {
+        Entrant *e = &entrants[i];
+        if (bots == 0) {
+            snprintf(e->name, sizeof(e->name), "%s", store->records[i].name);
+            e->kind = ENTRANT_PROFILE;
+            e->model = store->records[i].model;
+            continue;
+        }
+        // Bots cycle through the kinds; scripted ones also vary their offset
+        int kind = i % 4;
+        snprintf(e->name, MAX_NAME_LEN, "bot-%s-%d", kindNames[kind], i + 1);
+        e->kind = kind == 3 ? ENTRANT_ADAPTIVE : ENTRANT_STRATEGY;
+        e->strategy = kind < 3 ? findStrategy(kindNames[kind]) : NULL;
+        e->offset = (i / 4) % 4;
+    }
+    *count = n;
+    return entrants;
+}
+
+static const EntrantResult *standingsResults;
+static const Entrant *standingsEntrants;
+static const int *standingsReached;
+
+/* Standings order: knockout stage reached, matches won, rounds won, all
+   descending, then name */
+static int compareStandings(const void *a, const void *b) {
+    int ia = *(const int *)a;
+    int ib = *(const int *)b;
+    if (standingsReached && standingsReached[ia] != standingsReached[ib]) {
+        return standingsReached[ia] < standingsReached[ib] ? 1 : -1;
+    }
+    const EntrantResult *ra = &standingsResults[ia];
+    const EntrantResult *rb = &standingsResults[ib];
+    if (ra->matchWins != rb->matchWins) return ra->matchWins < rb->matchWins ? 1 : -1;
+    if (ra->roundWins != rb->roundWins) return ra->roundWins < rb->roundWins ? 1 : -1;
+    return strcmp(standingsEntrants[ia].name, standingsEntrants[ib].name);
+}
+
+// Adds the profiles' results to the score log in a single write, then folds
+// them into the leaderboard in one catch-up pass. As in playGame, only won
+// games count: each profile's line sums the matches it won. Bots are not
+// players and are left out.
+static int mergeIntoLeaderboard(Leaderboard *lb, const Entrant *entrants, const EntrantResult *results, int count) {
+    char *buf = malloc((size_t)count * (MAX_NAME_LEN + 64));
+    if (!buf) return 0;
+    size_t len = 0;
+    for (int i = 0; i < count; i++) {
+        if (entrants[i].kind != ENTRANT_PROFILE || results[i].matchWins == 0) continue;
+        len += (size_t)sprintf(buf + len, "%s %ld %ld %ld\n", entrants[i].name, results[i].wonRounds,
+                               results[i].wonRoundWins, results[i].wonRounds - results[i].wonRoundWins);
+    }
+    if (!processLock(LOCK_LEADERBOARD, 1)) {
+        free(buf);
+        return 0;
+    }
+    int ok = len == 0 || durableWrite(HIGHSCORE_FILE, buf, len);
+    free(buf);
+    if (ok) ok = leaderboardCatchUp(lb);
+    processUnlock(LOCK_LEADERBOARD);
+    durableSync();
+    return ok;
+}
+
+// Replaces tournament.txt with the full standings of a bot tournament.
+static int saveBotStandings(const Entrant *entrants, const EntrantResult *results, const int *order, int count) {
+    const char *tmpPath = TOURNAMENT_FILE ".tmp";
+    FILE *out = fopen(tmpPath, "w");
+    if (!out) return 0;
+    fprintf(out, "# rank entrant matches won rounds rounds_won\n");
+    for (int i = 0; i < count; i++) {
+        const EntrantResult *res = &results[order[i]];
+        fprintf(out, "%d %s %ld %ld %ld %ld\n", i + 1, entrants[order[i]].name, res->matches, res->matchWins,
+                res->rounds, res->roundWins);
+    }
+    return atomicReplaceFile(out, tmpPath, TOURNAMENT_FILE);
+}
+
+// In a knockout every match win takes an entrant one stage further, and a
+// bye is the only other way through, so stages reached = wins + byes.
+static int knockoutConsistent(const EntrantResult *results, const int *reached, const int *byes, int count) {
+    for (int i = 0; i < count; i++) {
+        if (byes[i] > 1 || results[i].matchWins + byes[i] != reached[i]) return 0;
+    }
+    return 1;
+}
+
+int runTournament(ProfileStore *store, Leaderboard *lb, const Rng *rng, int bots, BracketKind bracket,
+                  int mode, int rounds, int threads) {
+    if (rounds < 1 || rounds > MAX_ROUNDS || bots < 0 || bots == 1 || bots > MAX_ENTRANTS) {
+        printf("Rounds must be 1-%d and bots 2-%d (or 0 for all profiles).\n", MAX_ROUNDS, MAX_ENTRANTS);
+        return 0;
+    }
+    int count = 0;
+    if (!storeLock(store, 0)) return 0;
+    Entrant *entrants = makeEntrants(store, bots, &count);
+    storeUnlock(store);
+    if (!entrants) return 0;
+    if (count < 2) {
+        printf("A tournament needs at least 2 entrants.\n");
+        free(entrants);
+        return 0;
+    }
+    if (threads < 1) threads = 1;
+    if (threads > MAX_SIM_THREADS) threads = MAX_SIM_THREADS;
+
+    Tournament t;
+    memset(&t, 0, sizeof(t));
+    t.entrants = entrants;
+    t.count = count;
+    t.mode = mode;
+    t.rounds = rounds;
+    t.rng = *rng;
+    t.results = calloc((size_t)threads * (size_t)count, sizeof(EntrantResult));
+    int *field = malloc(sizeof(int) * (size_t)count);
+    int *order = malloc(sizeof(int) * (size_t)count);
+    int *reached = calloc((size_t)count, sizeof(int)); // knockout rounds survived
+    int *byes = calloc((size_t)count, sizeof(int));
+    int ok = t.results && field && order && reached && byes;
+
+    long matches = 0;
+    int champion = -1;
+    double start = monotonicSeconds();
+    if (ok && bracket == BRACKET_ROUND_ROBIN) {
+        matches = (long)count * (count - 1) / 2;
+        ok = poolRun(count, threads, roundRobinTask, &t);
+    } else if (ok) {
+        // Random seeding. Byes are all given in the first round, to the
+        // first entrants of the draw, so that every later round has a power
+        // of two entrants and no entrant ever gets a second bye
+        Rng draw = *rng;
+        for (int i = 0; i < count; i++) field[i] = i;
+        for (int i = count - 1; i > 0; i--) {
+            int j = (int)rngBounded(&draw, (uint32_t)i + 1);
+            int tmp = field[i];
+            field[i] = field[j];
+            field[j] = tmp;
+        }
+        int bracketSize = 1;
+        while (bracketSize < count) bracketSize *= 2;
+        int byeCount = bracketSize - count;
+        int fieldSize = count;
+        while (ok && fieldSize > 1) {
+            int pairs = (fieldSize - byeCount) / 2;
+            for (int i = 0; i < byeCount; i++) {
+                order[i] = field[i];
+                byes[field[i]]++;
+            }
+            t.field = field + byeCount;
+            t.winners = order + byeCount; // scratch until the standings are sorted
+            ok = poolRun(pairs, threads < pairs ? threads : pairs, knockoutTask, &t);
+            fieldSize = byeCount + pairs;
+            memcpy(field, order, sizeof(int) * (size_t)fieldSize);
+            for (int i = 0; i < fieldSize; i++) reached[field[i]]++;
+            matches += pairs;
+            byeCount = 0;
+        }
+        champion = field[0];
+    }
+    double elapsed = monotonicSeconds() - start;
+
+    if (ok) {
+        // Fold the per-worker totals into worker 0's row
+        for (int w = 1; w < threads; w++) {
+            for (int i = 0; i < count; i++) {
+                EntrantResult *dst = &t.results[i];
+                const EntrantResult *src = &t.results[(size_t)w * (size_t)count + (size_t)i];
+                dst->matches += src->matches;
+                dst->matchWins += src->matchWins;
+                dst->rounds += src->rounds;
+                dst->roundWins += src->roundWins;
+                dst->wonRounds += src->wonRounds;
+                dst->wonRoundWins += src->wonRoundWins;
+            }
+        }
+        for (int i = 0; i < count; i++) order[i] = i;
+        standingsResults = t.results;
+        standingsEntrants = entrants;
+        standingsReached = bracket == BRACKET_KNOCKOUT ? reached : NULL;
+        qsort(order, (size_t)count, sizeof(int), compareStandings);
+        if (bracket == BRACKET_KNOCKOUT && !knockoutConsistent(t.results, reached, byes, count)) {
+            printf("Error: Knockout results are inconsistent.\n");
+            ok = 0;
+        }
+    }
+
+    if (ok) {
+
+        printHeader("Tournament Results");
+        printf("Format: %s | Entrants: %d | Mode: %s | Rounds: %d | Threads: %d\n",
+               bracket == BRACKET_KNOCKOUT ? "Knockout" : "Round robin", count,
+               modeName(mode), rounds, threads);
+        if (champion != -1) printf("Champion: %s\n", entrants[champion].name);
+        printDivider();
+        printf("%-4s | %-20s | %-8s | %-8s | %s\n", "Rank", "Entrant", "Matches", "Won", "Rounds won");
+        int shown = count < TOURNAMENT_SHOW ? count : TOURNAMENT_SHOW;
+        for (int i = 0; i < shown; i++) {
+            const EntrantResult *res = &t.results[order[i]];
+            printf("%-4d | %-20s | %-8ld | %-8ld | %.1f%%\n", i + 1, entrants[order[i]].name, res->matches,
+                   res->matchWins, res->rounds ? 100.0 * res->roundWins / res->rounds : 0.0);
+        }
+        if (shown < count) printf("Showing top %d of %d entrants.\n", shown, count);
+        printDivider();
+        printf("Matches: %ld in %.3f s  (%.0f matches/sec)\n", matches, elapsed,
+               elapsed > 0 ? matches / elapsed : 0.0);
+        printFooter();
+        if (bots > 0) {
+            ok = saveBotStandings(entrants, t.results, order, count);
+            if (ok) printf("Standings saved to %s.\n", TOURNAMENT_FILE);
+        } else {
+            ok = mergeIntoLeaderboard(lb, entrants, t.results, count);
+        }
+        if (!ok) printf("Error saving tournament scores.\n");
     }
-    return move;
-}
 
-const char *computerMove(int mode) {
-    static const char *basicMoves[4] = {"L", "R", "U", "D"};
-    static const char *advMoves[4] = {"LU", "LD", "RU", "RD"};
-    int choice = rand() % 4;
-    if (mode == 1) {
-        return basicMoves[choice];
-    } else {
-        return advMoves[choice];
-    }
+    free(t.results);
+    free(field);
+    free(order);
+    free(reached);
+    free(byes);
+    free(entrants);
+    return ok;
 }
 
-void printRoundResult(const char *playerMove, const char *compMove, int *win, int *loss) {
-    if (strcmp(playerMove, compMove) == 0) {
-        printf("You LOSE this round!\n");
-        (*loss)++;
-    } else {
-        printf("You WIN this round!\n");
-        (*win)++;
+void tournamentMenu(ProfileStore *store, Leaderboard *lb, Rng *rng) {
+    printHeader("Tournament");
+    printf("1) All profiles\n");
+    printf("2) Bots\n");
+    printDivider();
+    int bots = 0;
+    if (getIntInRange("Select entrants: ", 1, 2) == 2) {
+        bots = getIntInRange("Number of bots: ", 2, MAX_ENTRANTS);
     }
+    printf("1) Round robin\n");
+    printf("2) Knockout\n");
+    BracketKind bracket = getIntInRange("Select format: ", 1, 2) == 2 ? BRACKET_KNOCKOUT : BRACKET_ROUND_ROBIN;
+    char question[RULES_TEXT_LEN * 3];
+    modeQuestion(question, sizeof(question));
+    int mode = confirmYesNo(question) ? 2 : 1;
+    int rounds = getIntInRange("Enter number of rounds (1-20): ", 1, MAX_ROUNDS);
+    runTournament(store, lb, rng, bots, bracket, mode, rounds, (int)sysconf(_SC_NPROCESSORS_ONLN));
+    rngNext(rng); // the next tournament gets a fresh draw
+    pauseProgram();
 }
 
-void playGame(Profile profiles[], int profCount) {
-    if (profCount == 0) {
-        printf("No profiles available. Please add one first.\n");
-        pauseProgram();
-        return;
-    }
-    showProfiles(profiles, profCount);
-    int idx = getIntInRange("Select your profile number: ", 1, profCount) - 1;
+// SESSION REPLAY
+//
+// Every logged session carries the seed its Rng started from, so it can be
+// re-run through the same opponentMove/modelLearn calls the game made, with
+// the player's recorded moves, and each computer move checked. An adaptive
+// game also depends on the player's model; it is rebuilt by replaying that
+// player's earlier sessions in log order from an empty model, just as the
+// profile learned it. (A renamed or re-created profile starts from a model
+// the log does not explain, so its adaptive sessions show as mismatches.)
+//
+// Sessions are numbered from 1 in log order, skipping damaged records, the
+// same order Game History lists them in.
 
-    Profile *playerProfile = &profiles[idx];
+typedef struct {
+    char name[MAX_NAME_LEN];
+    OpponentModel model;
+} ReplayPlayer;
 
-    printf("Welcome %s!\n", playerProfile->name);
+// The players one thread owns and its tallies
+typedef struct {
+    ReplayPlayer *players;
+    int count;
+    int cap;
+    NameIndex index;
+    ReplayReport report;
+    int failed;
+} ReplayShard;
 
-    int mode = 1;
-    if (confirmYesNo("Use Advanced mode (A/B/C/E)?")) {
-        mode = 2;
+// One batch of decoded sessions; shardOf[i] says which thread replays records[i]
+typedef struct {
+    LogRecord *records;
+    int *shardOf;
+    int count;
+    long firstNumber;   // session number of records[0]
+    ReplayShard *shards;
+} ReplayBatch;
+
+// Re-runs one session. `model` is the player's model from before it and is
+// learned forward as the game did, whether or not the session can be checked.
+// compMoves (may be NULL) receives the replayed computer moves. Returns 1 if
+// every computer move and the win count match, 0 if not, -1 if the session
+// has no seed and -2 if it was played under a different rule set.
+int replaySession(const LogRecord *rec, OpponentModel *model, uint8_t *compMoves) {
+    if (rec->seeded && rec->rulesHash != gameRules()->hash) {
+        // The computer's moves cannot be re-run under other rules, but the
+        // live game still taught the model the player's moves
+        uint64_t history = 0;
+        for (int r = 0; r < rec->rounds; r++) {
+            Move playerMove = pickMove(rec->mode, rec->playerMoves[r]);
+            modelLearn(model, rec->mode, history, r, playerMove);
+            setHistoryMove(&history, r, playerMove);
+        }
+        return -2;
     }
+    Rng rng;
+    rngSeed(&rng, rec->engine, rec->seed);
+    uint64_t history = 0;
+    int wins = 0;
+    int same = 1;
+    for (int r = 0; r < rec->rounds; r++) {
+        Move playerMove = pickMove(rec->mode, rec->playerMoves[r]);
+        Move compMove = opponentMove(rec->opponent == OPPONENT_ADAPTIVE ? model : NULL,
+                                     &rng, rec->mode, history, r);
+        modelLearn(model, rec->mode, history, r, playerMove);
+        setHistoryMove(&history, r, playerMove);
+        if (compMoves) compMoves[r] = (uint8_t)(compMove & 3);
+        same &= (compMove & 3) == rec->compMoves[r];
+        wins += scoreRound(playerMove, compMove);
+    }
+    if (!rec->seeded) return -1;
+    return same && wins == rec->wins;
+}
 
-    int rounds = getIntInRange("Enter number of rounds (1-20): ", 1, MAX_ROUNDS);
+static OpponentModel *replayModel(ReplayShard *sh, const char *name) {
+    if (!ensureIndex(&sh->index, sh->count, sh->count + 1)) return NULL;
+    int slot = indexSlot(&sh->index, name);
+    if (sh->index.slots[slot] == -1) {
+        if (sh->count == sh->cap) {
+            int cap = sh->cap ? sh->cap * 2 : INITIAL_RECORD_CAPACITY;
+            ReplayPlayer *grown = realloc(sh->players, sizeof(ReplayPlayer) * (size_t)cap);
+            if (!grown) return NULL;
+            sh->players = grown;
+            sh->cap = cap;
+            sh->index.base = (const char *)grown;
+        }
+        ReplayPlayer *p = &sh->players[sh->count];
+        memset(p, 0, sizeof(*p));
+        snprintf(p->name, sizeof(p->name), "%s", name);
+        sh->index.slots[slot] = sh->count++;
+    }
+    return &sh->players[sh->index.slots[slot]].model;
+}
 
-    GameSession session = {0};
-    strncpy(session.playerName, playerProfile->name, MAX_NAME_LEN - 1);
-    session.roundsPlayed = rounds;
-    session.wins = 0;
-    session.losses = 0;
+static void replayShardTask(void *ctx, long task, int worker) {
+    (void)worker;
+    ReplayBatch *b = ctx;
+    ReplayShard *sh = &b->shards[task];
+    ReplayReport *rep = &sh->report;
+    for (int i = 0; i < b->count; i++) {
+        if (b->shardOf[i] != task) continue;
+        OpponentModel *model = replayModel(sh, b->records[i].playerName);
+        if (!model) {
+            sh->failed = 1;
+            return;
+        }
+        int result = replaySession(&b->records[i], model, NULL);
+        rep->sessions++;
+        if (result == -2) {
+            rep->otherRules++;
+        } else if (result < 0) {
+            rep->unseeded++;
+        } else if (result) {
+            rep->verified++;
+        } else {
+            rep->mismatched++;
+            if (rep->badCount < REPLAY_REPORT) rep->firstBad[rep->badCount++] = b->firstNumber + i;
+        }
+    }
+}
 
-    printEmptyLines(1);
+static int compareLong(const void *a, const void *b) {
+    long x = *(const long *)a;
+    long y = *(const long *)b;
+    return (x > y) - (x < y);
+}
 
-    for (int r = 0; r < rounds; r++) {
-        printf("Round %d\n", r + 1);
+// Re-runs every session in the log at path, REPLAY_BATCH at a time. Players
+// are split between threads by name hash, so each thread replays its own
+// players' sessions in order without locking. Returns 0 if the log cannot be
+// read; mismatches are only counted.
+int verifyLog(const char *path, int threads, ReplayReport *report) {
+    memset(report, 0, sizeof(*report));
+    if (threads < 1) threads = 1;
+    LogReader *reader = malloc(sizeof(LogReader));
+    ReplayBatch b = {0};
+    b.records = malloc(sizeof(LogRecord) * REPLAY_BATCH);
+    b.shardOf = malloc(sizeof(int) * REPLAY_BATCH);
+    b.shards = calloc((size_t)threads, sizeof(ReplayShard));
+    b.firstNumber = 1;
+    int opened = reader && b.records && b.shardOf && b.shards && logReaderOpen(reader, path);
+    int ok = opened;
+    for (int t = 0; ok && t < threads; t++) b.shards[t].index.stride = sizeof(ReplayPlayer);
 
-        char input[MAX_MOVE_LEN];
-        while (1) {
-            if (mode == 1) {
-                printf("Enter your move (L,R,U,D): ");
-            } else {
-                printf("Enter your move (A=LU, B=LD, C=RU, E=RD or full LU/LD/RU/RD): ");
-            }
-            if (!readLine(input, MAX_MOVE_LEN)) {
-                printf("Input error, try again.\n");
-                continue;
-            }
-            if (!isValidMove(input, mode)) {
-                printf("Invalid move, please try again.\n");
-                continue;
-            }
-            break;
+    while (ok) {
+        b.count = 0;
+        while (b.count < REPLAY_BATCH && logReaderNext(reader, &b.records[b.count])) {
+            // High bits of the hash pick the shard; the low bits pick index slots
+            uint64_t h = hashName(b.records[b.count].playerName);
+            b.shardOf[b.count] = (int)((h * (uint64_t)threads) >> 32);
+            b.count++;
         }
+        if (b.count == 0) break;
+        ok = poolRun(threads, threads, replayShardTask, &b);
+        b.firstNumber += b.count;
+    }
 
-        char playerMove[MAX_MOVE_LEN] = {0};
-        if (mode == 1) {
-            playerMove[0] = (char)toupper(input[0]);
-            playerMove[1] = '\0';
-        } else {
-            if (isValidAdvancedMove(input)) {
-                const char *mapped = mapAdvancedMove(input);
-                if (mapped) {
-                    strncpy(playerMove, mapped, MAX_MOVE_LEN - 1);
-                }
+    long bad[REPLAY_REPORT * 2];
+    for (int t = 0; b.shards && t < threads; t++) {
+        ReplayShard *sh = &b.shards[t];
+        ReplayReport *rep = &sh->report;
+        report->sessions += rep->sessions;
+        report->verified += rep->verified;
+        report->mismatched += rep->mismatched;
+        report->unseeded += rep->unseeded;
+        report->otherRules += rep->otherRules;
+        // Each shard's list is ascending, so merging keeps the overall first ones
+        for (int i = 0; i < rep->badCount; i++) {
+            if (report->badCount < REPLAY_REPORT) {
+                bad[report->badCount++] = rep->firstBad[i];
             } else {
-                strncpy(playerMove, input, MAX_MOVE_LEN - 1);
-                toUpperStr(playerMove);
+                bad[REPLAY_REPORT] = rep->firstBad[i];
+                qsort(bad, REPLAY_REPORT + 1, sizeof(long), compareLong);
             }
         }
+        if (sh->failed) ok = 0;
+        free(sh->players);
+        free(sh->index.slots);
+    }
+    qsort(bad, (size_t)report->badCount, sizeof(long), compareLong);
+    memcpy(report->firstBad, bad, sizeof(long) * (size_t)report->badCount);
+    if (opened) {
+        report->corrupt = reader->corrupt;
+        logReaderClose(reader);
+    }
+    free(reader);
+    free(b.records);
+    free(b.shardOf);
+    free(b.shards);
+    return ok;
+}
 
-        const char *compMove = computerMove(mode);
-
-        printf("Computer chose: %s\n", compMove);
+// Verifies the whole stats log and prints the report. Returns 1 only if every
+// session that has a seed replays exactly.
+int runVerifyLog(int threads) {
+    if (threads < 1) threads = 1;
+    ReplayReport rep;
+    double start = monotonicSeconds();
+    if (!verifyLog(STATS_FILE, threads, &rep)) {
+        printf("Error: Could not verify %s.\n", STATS_FILE);
+        return 0;
+    }
+    double elapsed = monotonicSeconds() - start;
 
-        strncpy(session.movesHistory[r], playerMove, MAX_MOVE_LEN - 1);
-        strncpy(session.compMovesHistory[r], compMove, MAX_MOVE_LEN - 1);
+    printHeader("Session Verification");
+    printf("Sessions:            %ld\n", rep.sessions);
+    printf("Replayed exactly:    %ld\n", rep.verified);
+    printf("Mismatched:          %ld\n", rep.mismatched);
+    if (rep.badCount > 0) {
+        printf("  first at session:");
+        for (int i = 0; i < rep.badCount; i++) printf(" #%ld", rep.firstBad[i]);
+        printf("\n");
+    }
+    printf("Logged without seed: %ld\n", rep.unseeded);
+    if (rep.otherRules > 0) {
+        printf("Other rule set:      %ld (not replayed; load the rules they were played under)\n",
+               rep.otherRules);
+    }
+    if (rep.corrupt > 0) {
+        printf("Damaged (skipped):   %ld\n", rep.corrupt);
+    }
+    printf("Time: %.3f s with %d thread(s) (%.0f sessions/sec)\n",
+           elapsed, threads, elapsed > 0 ? rep.sessions / elapsed : 0.0);
+    printFooter();
+    return rep.mismatched == 0;
+}
 
-        printRoundResult(playerMove, compMove, &session.wins, &session.losses);
+// Replays one session round by round next to what was logged.
+int showSession(long number) {
+    LogReader *reader = malloc(sizeof(LogReader));
+    if (!reader || !logReaderOpen(reader, STATS_FILE)) {
+        printf("No game stats recorded yet.\n");
+        free(reader);
+        return 0;
+    }
+    LogRecord rec;
+    long n = 0;
+    while (n < number && logReaderNext(reader, &rec)) n++;
+    if (number < 1 || n < number) {
+        printf("There is no session #%ld; the log holds %ld.\n", number, n);
+        logReaderClose(reader);
+        free(reader);
+        return 0;
+    }
+    LogRecord target = rec;
 
-        printEmptyLines(1);
+    // The player's earlier sessions bring the model up to where it stood
+    OpponentModel model;
+    memset(&model, 0, sizeof(model));
+    logReaderSeek(reader, 0);
+    for (long i = 1; i < number && logReaderNext(reader, &rec); i++) {
+        if (strcmp(rec.playerName, target.playerName) == 0) replaySession(&rec, &model, NULL);
     }
+    logReaderClose(reader);
+    free(reader);
 
-    printDivider();
-    printf("Game over! %s's Results:\n", session.playerName);
-    printf("Rounds Played: %d\n", session.roundsPlayed);
-    printf("Wins: %d\n", session.wins);
-    printf("Losses: %d\n", session.losses);
+    char when[32];
+    time_t t = (time_t)target.timestamp;
+    struct tm tm;
+    strftime(when, sizeof(when), "%Y-%m-%d %H:%M", localtime_r(&t, &tm));
+    printHeader("Session Replay");
+    printf("Session #%ld | Player: %s | Mode: %s | Rounds: %d | %s\n", number, target.playerName,
+           modeName(target.mode), target.rounds, when);
+    if (!target.seeded) {
+        printf("This session was logged without a seed and cannot be replayed.\n");
+        printFooter();
+        return 0;
+    }
+    printf("Seed: %llu (%s, %s opponent)\n", (unsigned long long)target.seed,
+           target.engine == RNG_PCG ? "pcg" : "xoshiro",
+           target.opponent == OPPONENT_ADAPTIVE ? "adaptive" : "random");
     printDivider();
 
-    if (session.wins > session.losses) {
-    printf("You won the game! Congratulations!\n");
-    saveScoreToFile(&session);
-    } else if (session.wins < session.losses) {
-        printf("You lost the game. Better luck next time!\n");
+    uint8_t replayed[MAX_ROUNDS];
+    int result = replaySession(&target, &model, replayed);
+    if (result == -2) {
+        printf("This session was played under a different rule set (%08x; current %08x),\n"
+               "so it cannot be replayed with the current rules.\n",
+               target.rulesHash, gameRules()->hash);
+        printFooter();
+        return 0;
+    }
+    for (int r = 0; r < target.rounds; r++) {
+        Move playerMove = pickMove(target.mode, target.playerMoves[r]);
+        Move logged = pickMove(target.mode, target.compMoves[r]);
+        Move again = pickMove(target.mode, replayed[r]);
+        printf("Round %2d: player %-2s  computer %-2s  replayed %-2s  %s\n", r + 1,
+               moveToString(playerMove), moveToString(logged), moveToString(again),
+               logged != again ? "MISMATCH" : scoreRound(playerMove, again) ? "win" : "loss");
+    }
+    printDivider();
+    if (result == 1) {
+        printf("Replay matches the log: %d win(s), %d loss(es).\n", target.wins, target.losses);
     } else {
-        printf("The game was a draw!\n");
+        printf("Replay does NOT match the logged session.\n");
     }
+    printFooter();
+    return result == 1;
+}
 
-    updateProfileStats(playerProfile, &session);
-    saveProfiles(profiles, profCount);
-    saveGameStats(&session, mode);
-
+void replaySessionMenu() {
+    long number = getIntInRange("Enter session number (as listed in Game History): ", 1, INT_MAX);
+    showSession(number);
     pauseProgram();
 }
 
-// SCOREBOARD
+// GAME SERVER
+//
+// hrst --serve <port | unix:path> plays the game with any number of
+// concurrent clients over a line-based text protocol, e.g.
+//
+//   printf 'alice\nn\n3\nL\nR\nU\nn\n' | nc localhost 7777
+//
+// Each client walks the same flow as playGame: name (profile is created on
+// first use), mode, rounds, one move per round, then "play again", where "s"
+// shows the scoreboard. Rounds and results go through the same game core as
+// playGame, written to the client's buffer instead of stdout. Profile
+// management stays on the console. SIGINT or SIGTERM stops the server
+// cleanly, so the caller's final sync still runs.
 
-void saveScoreToFile(GameSession *session) {
-    FILE *fp = fopen(HIGHSCORE_FILE, "a");
-    if (!fp) {
-        printf("Error saving score.\n");
-        return;
+static int serverStopPipe[2] = {-1, -1};
+
+static void serverStopSignal(int sig) {
+    (void)sig;
+    int saved = errno;
+    if (write(serverStopPipe[1], "x", 1) < 0) {
+        // The pipe is full, so a stop is already pending
     }
-    fprintf(fp, "%s %d %d %d\n", session->playerName, session->roundsPlayed, session->wins, session->losses);
-    fclose(fp);
+    errno = saved;
 }
 
-// Global ScoreEntry struct so comparator can see it
-typedef struct {
-    char name[MAX_NAME_LEN];
-    int gamesPlayed;
-    int wins;
-    int losses;
-} ScoreEntry;
-
-/* FIXED comparator – place OUTSIDE any function */
-int compare(const void *a, const void *b) {
-    const ScoreEntry *sa = (const ScoreEntry *)a;
-    const ScoreEntry *sb = (const ScoreEntry *)b;
+// Output sink for a client: appends to its send buffer.
+static void clientWrite(void *ctx, const char *text, size_t len) {
+    ClientSession *c = ctx;
+    if (c->outLen + len > c->outCap) {
+        size_t cap = c->outCap ? c->outCap : MAX_LINE;
+        while (c->outLen + len > cap) cap *= 2;
+        char *out = realloc(c->out, cap);
+        if (!out) {
+            c->closing = 1;
+            return;
+        }
+        c->out = out;
+        c->outCap = cap;
+    }
+    memcpy(c->out + c->outLen, text, len);
+    c->outLen += len;
+}
 
-    /* wins descending */
-    if (sa->wins < sb->wins) return 1;
-    if (sa->wins > sb->wins) return -1;
+static void clientPrompt(ClientSession *c) {
+    switch (c->state) {
+        case CLIENT_NAME:
+            outPrintf(&c->output, "Enter your player name: ");
+            break;
+        case CLIENT_MODE:
+            outPrintf(&c->output, "Use %s mode (%s)? (y/n): ", modeName(2), gameRules()->modes[1].keyHint);
+            break;
+        case CLIENT_ROUNDS:
+            outPrintf(&c->output, "Enter number of rounds (1-%d): ", MAX_ROUNDS);
+            break;
+        case CLIENT_MOVE:
+            gamePrompt(&c->game, &c->output);
+            break;
+        case CLIENT_AGAIN:
+            outPrintf(&c->output, "Play again? (y/n, s = scoreboard): ");
+            break;
+    }
+}
 
-    /* tie-breaker: name ascending */
-    return strcmp(sa->name, sb->name);
+// Plays one round with the player's move and finishes the game after the last.
+static void clientPlayRound(Server *srv, ClientSession *c, Move playerMove) {
+    if (gamePlayRound(&c->game, playerMove, &c->output)) {
+        gameFinish(&c->game, srv->store, srv->lb, &c->output);
+        c->state = CLIENT_AGAIN;
+    }
 }
 
-void displayScoreboard() {
-    FILE *fp = fopen(HIGHSCORE_FILE, "r");
-    if (!fp) {
-        printf("No scores available yet.\n");
-        pauseProgram();
-        return;
+// Advances the client's state machine by one input line.
+static void clientHandleLine(Server *srv, ClientSession *c, char *line) {
+    char answer = (char)tolower((unsigned char)line[0]);
+    switch (c->state) {
+        case CLIENT_NAME:
+            if (strlen(line) == 0 || strlen(line) >= MAX_NAME_LEN || strchr(line, ' ')) {
+                outPrintf(&c->output, "Name must be 1-%d characters with no spaces.\n", MAX_NAME_LEN - 1);
+                break;
+            }
+            snprintf(c->name, sizeof(c->name), "%s", line);
+            outPrintf(&c->output, "Welcome %s!\n", c->name);
+            c->state = CLIENT_MODE;
+            break;
+        case CLIENT_MODE:
+            if (answer != 'y' && answer != 'n') {
+                outPrintf(&c->output, "Please answer 'y' or 'n'.\n");
+                break;
+            }
+            c->mode = answer == 'y' ? 2 : 1;
+            c->state = CLIENT_ROUNDS;
+            break;
+        case CLIENT_ROUNDS: {
+            int rounds;
+            if (sscanf(line, "%d", &rounds) != 1 || rounds < 1 || rounds > MAX_ROUNDS) {
+                outPrintf(&c->output, "Please enter a number between 1 and %d.\n", MAX_ROUNDS);
+                break;
+            }
+            gameBegin(&c->game, srv->store, &srv->rng, srv->opponent, c->name, c->mode, rounds);
+            c->state = CLIENT_MOVE;
+            break;
+        }
+        case CLIENT_MOVE: {
+            Move playerMove = parseMove(line, c->game.mode);
+            if (playerMove == MOVE_NONE) {
+                outPrintf(&c->output, "Invalid move, please try again.\n");
+                break;
+            }
+            clientPlayRound(srv, c, playerMove);
+            break;
+        }
+        case CLIENT_AGAIN:
+            if (answer == 'y') {
+                c->state = CLIENT_MODE;
+            } else if (answer == 'n') {
+                outPrintf(&c->output, "Thank you for playing Cham Cham Cham!\n");
+                c->closing = 1;
+                return;
+            } else if (answer == 's') {
+                writeScoreboard(srv->lb, &c->output);
+            } else {
+                outPrintf(&c->output, "Please answer 'y' or 'n'.\n");
+            }
+            break;
     }
+    clientPrompt(c);
+}
 
+static int setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
 
-    ScoreEntry scores[200];
-    int count = 0;
-    char line[MAX_LINE];
+// Registers fd for readability, plus writability while output is pending.
+static void serverWatch(Server *srv, int fd, int wantWrite, int isNew) {
+#ifdef __linux__
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | (wantWrite ? EPOLLOUT : 0);
+    ev.data.fd = fd;
+    epoll_ctl(srv->eventFd, isNew ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &ev);
+#else
+    (void)srv;
+    (void)fd;
+    (void)wantWrite;
+    (void)isNew; // poll() rebuilds its set from the client table every wait
+#endif
+}
 
-    while (fgets(line, sizeof(line), fp)) {
-        char name[MAX_NAME_LEN];
-        int games, wins, losses;
+static void serverDropClient(Server *srv, ClientSession *c) {
+    timerCancel(&srv->timers, &c->timer);
+#ifdef __linux__
+    epoll_ctl(srv->eventFd, EPOLL_CTL_DEL, c->fd, NULL);
+#endif
+    srv->clients[c->fd] = NULL;
+    srv->clientCount--;
+    close(c->fd);
+    free(c->out);
+    free(c);
+}
 
-        if (sscanf(line, "%49s %d %d %d", name, &games, &wins, &losses) != 4) {
-            continue;
+// Restarts the client's deadline for whatever it is now waiting on.
+static void clientArmTimer(Server *srv, ClientSession *c) {
+    uint64_t timeout = c->state == CLIENT_MOVE ? SERVER_MOVE_TIMEOUT_MS : SERVER_IDLE_TIMEOUT_MS;
+    timerSchedule(&srv->timers, &c->timer, monotonicMillis() + timeout);
+}
+
+// Sends as much pending output as the socket takes; returns 0 on error.
+static int clientFlush(Server *srv, ClientSession *c) {
+    size_t sent = 0;
+    while (sent < c->outLen) {
+        ssize_t n = send(c->fd, c->out + sent, c->outLen - sent, 0);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            if (errno == EINTR) continue;
+            return 0;
         }
+        sent += (size_t)n;
+    }
+    memmove(c->out, c->out + sent, c->outLen - sent);
+    c->outLen -= sent;
+    serverWatch(srv, c->fd, c->outLen > 0, 0);
+    return 1;
+}
 
-        int found = 0;
-        for (int i = 0; i < count; i++) {
-            if (strcmp(scores[i].name, name) == 0) {
-                scores[i].gamesPlayed += games;
-                scores[i].wins += wins;
-                scores[i].losses += losses;
-                found = 1;
-                break;
+static void serverAccept(Server *srv) {
+    while (1) {
+        int fd = accept(srv->listenFd, NULL, NULL);
+        if (fd < 0) return; // EAGAIN: no more pending connections
+        if (!setNonBlocking(fd)) {
+            close(fd);
+            continue;
+        }
+        if (fd >= srv->clientCap) {
+            int cap = srv->clientCap ? srv->clientCap : 64;
+            while (fd >= cap) cap *= 2;
+            ClientSession **clients = realloc(srv->clients, sizeof(ClientSession *) * cap);
+            if (!clients) {
+                close(fd);
+                continue;
             }
+            memset(clients + srv->clientCap, 0, sizeof(ClientSession *) * (cap - srv->clientCap));
+            srv->clients = clients;
+            srv->clientCap = cap;
         }
-
-        if (!found) {
-            if (count >= 200) break;
-            strncpy(scores[count].name, name, MAX_NAME_LEN - 1);
-            scores[count].name[MAX_NAME_LEN - 1] = '\0';
-            scores[count].gamesPlayed = games;
-            scores[count].wins = wins;
-            scores[count].losses = losses;
-            count++;
+        ClientSession *c = calloc(1, sizeof(ClientSession));
+        if (!c) {
+            close(fd);
+            continue;
         }
+        c->fd = fd;
+        c->state = CLIENT_NAME;
+        c->output.write = clientWrite;
+        c->output.ctx = c;
+        c->timer.owner = c;
+        srv->acceptedTotal++;
+        srv->clients[fd] = c;
+        srv->clientCount++;
+        serverWatch(srv, fd, 0, 1);
+        clientArmTimer(srv, c);
+        outPrintf(&c->output, "Welcome to Cham Cham Cham!\n");
+        clientPrompt(c);
+        clientFlush(srv, c);
     }
-    fclose(fp);
+}
 
-    if (count == 0) {
-        printf("No valid scores found.\n");
-        pauseProgram();
+// A client missed its deadline: an overdue move is played at random for it,
+// anything else means it has gone quiet and is disconnected. The move comes
+// from the server's Rng so the game's own stream stays replayable.
+static void clientTimedOut(Timer *timer, void *ctx) {
+    Server *srv = ctx;
+    ClientSession *c = timer->owner;
+    if (c->state == CLIENT_MOVE && !c->closing) {
+        Move move = computerMove(&srv->rng, c->game.mode);
+        outPrintf(&c->output, "\nTime's up! Playing %s for you.\n", moveToString(move));
+        clientPlayRound(srv, c, move);
+        clientPrompt(c);
+        clientArmTimer(srv, c);
+        if (!clientFlush(srv, c)) serverDropClient(srv, c);
         return;
     }
+    outPrintf(&c->output, "\nDisconnected after %d seconds of inactivity.\n", SERVER_IDLE_TIMEOUT_MS / 1000);
+    clientFlush(srv, c);
+    serverDropClient(srv, c);
+}
 
-    qsort(scores, count, sizeof(ScoreEntry), compare);
-
-    printHeader("Scoreboard");
-    printf("%-20s | %-12s | %-6s | %-6s\n", "Player Name", "Games Played", "Wins", "Losses");
-    printDivider();
-    for (int i = 0; i < count; i++) {
-        printf("%-20s | %-12d | %-6d | %-6d\n",
-               scores[i].name,
-               scores[i].gamesPlayed,
-               scores[i].wins,
-               scores[i].losses);
+// Reads what is available and runs every complete line through the state
+// machine; returns 0 when the client has gone away.
+static int clientRead(Server *srv, ClientSession *c) {
+    char buf[4096];
+    while (1) {
+        ssize_t n = recv(c->fd, buf, sizeof(buf), 0);
+        if (n == 0) return 0;
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                clientArmTimer(srv, c);
+                return 1;
+            }
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        for (ssize_t i = 0; i < n && !c->closing; i++) {
+            char ch = buf[i];
+            if (ch == '\n') {
+                if (!c->discarding) {
+                    if (c->inLen > 0 && c->in[c->inLen - 1] == '\r') c->inLen--;
+                    c->in[c->inLen] = '\0';
+                    clientHandleLine(srv, c, c->in);
+                }
+                c->inLen = 0;
+                c->discarding = 0;
+            } else if (c->inLen + 1 < sizeof(c->in)) {
+                c->in[c->inLen++] = ch;
+            } else {
+                c->discarding = 1;
+            }
+        }
     }
-    printFooter();
+}
 
-    pauseProgram();
+static int serverListen(const char *address) {
+    int fd;
+    if (strncmp(address, "unix:", 5) == 0) {
+        struct sockaddr_un sun;
+        memset(&sun, 0, sizeof(sun));
+        sun.sun_family = AF_UNIX;
+        strncpy(sun.sun_path, address + 5, sizeof(sun.sun_path) - 1);
+        unlink(sun.sun_path);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || bind(fd, (struct sockaddr *)&sun, sizeof(sun)) != 0) {
+            if (fd >= 0) close(fd);
+            return -1;
+        }
+    } else {
+        struct sockaddr_in sin;
+        memset(&sin, 0, sizeof(sin));
+        sin.sin_family = AF_INET;
+        sin.sin_addr.s_addr = htonl(INADDR_ANY);
+        sin.sin_port = htons((uint16_t)atoi(address));
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        if (fd < 0 || setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+            bind(fd, (struct sockaddr *)&sin, sizeof(sin)) != 0) {
+            if (fd >= 0) close(fd);
+            return -1;
+        }
+    }
+    if (listen(fd, SERVER_BACKLOG) != 0 || !setNonBlocking(fd)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
 }
 
-// GAME STATS LOGGING
+// Waits up to timeoutMs (-1 = no limit) for activity and fills fds/flags
+// (1 = readable, 2 = writable, 4 = hang-up or error). Returns the number of
+// ready descriptors, 0 on timeout.
+static int serverWait(Server *srv, int *fds, int *flags, int max, int timeoutMs) {
+#ifdef __linux__
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    int n = epoll_wait(srv->eventFd, events, max < SERVER_MAX_EVENTS ? max : SERVER_MAX_EVENTS, timeoutMs);
+    for (int i = 0; i < n; i++) {
+        fds[i] = events[i].data.fd;
+        flags[i] = ((events[i].events & EPOLLIN) ? 1 : 0) | ((events[i].events & EPOLLOUT) ? 2 : 0) |
+                   ((events[i].events & (EPOLLERR | EPOLLHUP)) ? 4 : 0);
+    }
+    return n;
+#else
+    struct pollfd *pfds = malloc(sizeof(struct pollfd) * (size_t)(srv->clientCount + 2));
+    if (!pfds) return -1;
+    int count = 0;
+    pfds[count].fd = srv->listenFd;
+    pfds[count++].events = POLLIN;
+    pfds[count].fd = srv->stopFd;
+    pfds[count++].events = POLLIN;
+    for (int fd = 0; fd < srv->clientCap; fd++) {
+        if (!srv->clients[fd]) continue;
+        pfds[count].fd = fd;
+        pfds[count++].events = POLLIN | (srv->clients[fd]->outLen ? POLLOUT : 0);
+    }
+    int n = poll(pfds, (nfds_t)count, timeoutMs);
+    int ready = 0;
+    for (int i = 0; i < count && n > 0 && ready < max; i++) {
+        if (!pfds[i].revents) continue;
+        fds[ready] = pfds[i].fd;
+        flags[ready++] = ((pfds[i].revents & POLLIN) ? 1 : 0) | ((pfds[i].revents & POLLOUT) ? 2 : 0) |
+                         ((pfds[i].revents & (POLLERR | POLLHUP)) ? 4 : 0);
+    }
+    free(pfds);
+    return n < 0 ? n : ready;
+#endif
+}
 
-void saveGameStats(GameSession *session, int mode) {
-    FILE *fp = fopen(STATS_FILE, "a");
-    if (!fp) return;
+int runServer(const char *address, ProfileStore *store, Leaderboard *lb, Rng *rng, OpponentKind opponent) {
+    Server srv;
+    memset(&srv, 0, sizeof(srv));
+    srv.store = store;
+    srv.lb = lb;
+    srv.rng = *rng;
+    srv.opponent = opponent;
+    srv.eventFd = -1;
+    timerWheelInit(&srv.timers, monotonicMillis());
+    signal(SIGPIPE, SIG_IGN); // a vanished client must not kill the server
 
-    fprintf(fp, "Player: %s | Mode: %s | Rounds: %d | Wins: %d | Losses: %d\n",
-            session->playerName,
-            mode == 1 ? "Basic" : "Advanced",
-            session->roundsPlayed,
-            session->wins,
-            session->losses);
-    fprintf(fp, "Moves (Player vs Computer):\n");
-    for (int i = 0; i < session->roundsPlayed; i++) {
-      fprintf(fp, "%s %d %d %d\n", session->playerName, 1, session->wins, session->losses);
+    srv.listenFd = serverListen(address);
+    if (srv.listenFd < 0) {
+        printf("Error: Could not listen on %s.\n", address);
+        return 0;
     }
-    fprintf(fp, "-----\n");
-
-    fclose(fp);
-}
+    // SIGINT and SIGTERM are turned into a readable byte on a self-pipe,
+    // which the wait below watches along with the clients
+    if (pipe(serverStopPipe) != 0) {
+        close(srv.listenFd);
+        return 0;
+    }
+    srv.stopFd = serverStopPipe[0];
+    setNonBlocking(serverStopPipe[0]);
+    setNonBlocking(serverStopPipe[1]);
+#ifdef __linux__
+    srv.eventFd = epoll_create1(0);
+    if (srv.eventFd < 0) {
+        close(serverStopPipe[0]);
+        close(serverStopPipe[1]);
+        close(srv.listenFd);
+        return 0;
+    }
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = srv.listenFd;
+    epoll_ctl(srv.eventFd, EPOLL_CTL_ADD, srv.listenFd, &ev);
+    ev.data.fd = srv.stopFd;
+    epoll_ctl(srv.eventFd, EPOLL_CTL_ADD, srv.stopFd, &ev);
+#endif
+    struct sigaction sa, oldInt, oldTerm;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = serverStopSignal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, &oldInt);
+    sigaction(SIGTERM, &sa, &oldTerm);
+    printf("Serving Cham Cham Cham on %s\n", address);
+    fflush(stdout);
 
-void viewGameStats() {
-    FILE *fp = fopen(STATS_FILE, "r");
-    if (!fp) {
-        printf("No game stats recorded yet.\n");
-        pauseProgram();
-        return;
+    int fds[SERVER_MAX_EVENTS];
+    int flags[SERVER_MAX_EVENTS];
+    int running = 1;
+    while (running) {
+        // Sleep until the next event or the next deadline, whichever is first
+        int timeout = timerWheelNextDelay(&srv.timers, monotonicMillis());
+        int n = serverWait(&srv, fds, flags, SERVER_MAX_EVENTS, timeout);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            if (fds[i] == srv.stopFd) {
+                running = 0;
+                continue;
+            }
+            if (fds[i] == srv.listenFd) {
+                serverAccept(&srv);
+                continue;
+            }
+            ClientSession *c = fds[i] < srv.clientCap ? srv.clients[fds[i]] : NULL;
+            if (!c) continue;
+            int alive = !(flags[i] & 4);
+            if (alive && (flags[i] & 1)) alive = clientRead(&srv, c);
+            if (alive) alive = clientFlush(&srv, c);
+            if (!alive || (c->closing && c->outLen == 0)) {
+                serverDropClient(&srv, c);
+            }
+        }
+        timerWheelAdvance(&srv.timers, monotonicMillis(), clientTimedOut, &srv);
     }
-    printHeader("Game Stats History");
-    char line[MAX_LINE];
-    while (fgets(line, MAX_LINE, fp)) {
-        printf("%s", line);
+
+    if (!running) printf("Shutting down; %ld client(s) disconnected.\n", srv.clientCount);
+    for (int fd = 0; fd < srv.clientCap; fd++) {
+        if (!srv.clients[fd]) continue;
+        outPrintf(&srv.clients[fd]->output, "\nServer shutting down.\n");
+        clientFlush(&srv, srv.clients[fd]);
+        serverDropClient(&srv, srv.clients[fd]);
     }
-    printFooter();
-    fclose(fp);
-    pauseProgram();
+    free(srv.clients);
+    if (srv.eventFd >= 0) close(srv.eventFd);
+    close(srv.listenFd);
+    sigaction(SIGINT, &oldInt, NULL);
+    sigaction(SIGTERM, &oldTerm, NULL);
+    close(serverStopPipe[0]);
+    close(serverStopPipe[1]);
+    serverStopPipe[0] = serverStopPipe[1] = -1;
+    return 1;
 }
 
 // MENU
 
-void mainMenu(Profile profiles[], int *profCount) {
+void mainMenu(ProfileStore *store, Leaderboard *lb, Rng *rng, OpponentKind opponent) {
     while (1) {
         printHeader("Main Menu");
         printf("1) Play Game\n");
@@ -668,19 +4306,20 @@ void mainMenu(Profile profiles[], int *profCount) {
         printf("3) Scoreboard\n");
         printf("4) View Game Stats\n");
         printf("5) Instructions\n");
+        printf("6) Tournament\n");
         printf("0) Exit\n");
         printDivider();
-        int choice = getIntInRange("Enter your choice: ", 0, 5);
+        int choice = getIntInRange("Enter your choice: ", 0, 6);
 
         switch (choice) {
             case 1:
-                playGame(profiles, *profCount);
+                playGame(store, lb, rng, opponent);
                 break;
             case 2:
-                profilesMenu(profiles, profCount);
+                profilesMenu(store);
                 break;
             case 3:
-                scoreboardMenu();
+                scoreboardMenu(lb);
                 break;
             case 4:
                 statsMenu();
@@ -688,6 +4327,9 @@ void mainMenu(Profile profiles[], int *profCount) {
             case 5:
                 instructionsMenu();
                 break;
+            case 6:
+                tournamentMenu(store, lb, rng);
+                break;
             case 0:
                 printf("Thank you for playing Cham Cham Cham!\n");
                 return;
@@ -697,7 +4339,7 @@ void mainMenu(Profile profiles[], int *profCount) {
     }
 }
 
-void profilesMenu(Profile profiles[], int *profCount) {
+void profilesMenu(ProfileStore *store) {
     while (1) {
         printHeader("Profiles Management");
         printf("1) List Profiles\n");
@@ -711,28 +4353,31 @@ void profilesMenu(Profile profiles[], int *profCount) {
         int choice = getIntInRange("Enter choice: ", 0, 5);
         switch (choice) {
             case 1:
-                showProfiles(profiles, *profCount);
-                pauseProgram();
-                break;
-            case 2:
-                addNewProfile(profiles, profCount);
-                break;
-            case 3:
-                renameProfile(profiles, *profCount);
-                break;
-            case 4:
-                deleteProfile(profiles, profCount);
+                if (store->count == 0) {
+                    printf("No profiles available.\n");
+                    pauseProgram();
+                } else {
+                    selectProfile(store, NULL);
+                }
                 break;
             case 5:
-                if (*profCount == 0) {
+                if (store->count == 0) {
                     printf("No profiles available.\n");
                     pauseProgram();
                 } else {
-                    showProfiles(profiles, *profCount);
-                    int sel = getIntInRange("Select profile number to view: ", 1, *profCount);
-                    viewProfileDetails(&profiles[sel - 1]);
+                    int sel = selectProfile(store, "view");
+                    if (sel != -1) viewProfileDetails(&store->records[sel]);
                 }
                 break;
+            case 2:
+                addNewProfile(store);
+                break;
+            case 3:
+                renameProfile(store);
+                break;
+            case 4:
+                deleteProfile(store);
+                break;
             case 0:
                 return;
             default:
@@ -741,35 +4386,95 @@ void profilesMenu(Profile profiles[], int *profCount) {
     }
 }
 
-void scoreboardMenu() {
-    displayScoreboard();
+void scoreboardMenu(Leaderboard *lb) {
+    displayScoreboard(lb);
 }
 
 void statsMenu() {
-    viewGameStats();
+    while (1) {
+        printHeader("Game Stats");
+        printf("1) Game History\n");
+        printf("2) Player Analytics\n");
+        printf("3) Replay a Session\n");
+        printf("4) Verify All Sessions\n");
+        printf("0) Return to Main Menu\n");
+        printDivider();
+
+        int choice = getIntInRange("Enter choice: ", 0, 4);
+        switch (choice) {
+            case 1:
+                viewGameStats();
+                break;
+            case 2:
+                viewPlayerAnalytics();
+                break;
+            case 3:
+                replaySessionMenu();
+                break;
+            case 4:
+                runVerifyLog((int)sysconf(_SC_NPROCESSORS_ONLN));
+                pauseProgram();
+                break;
+            case 0:
+                return;
+            default:
+                printf("Invalid choice, try again.\n");
+        }
+    }
 }
 
 void instructionsMenu() {
     printHeader("Instructions");
     printf("Welcome to Cham Cham Cham!\n\n");
-    printf("Basic mode moves:\n");
-    printf("L - Left\n");
-    printf("R - Right\n");
-    printf("U - Up\n");
-    printf("D - Down\n\n");
-
-    printf("Advanced mode moves:\n");
-    printf("A - LU (Left-Up)\n");
-    printf("B - LD (Left-Down)\n");
-    printf("C - RU (Right-Up)\n");
-    printf("E - RD (Right-Down)\n");
-    printf("Or directly input two-letter moves LU, LD, RU, RD.\n\n");
+    const Rules *r = gameRules();
+    for (int mode = 1; mode <= 2; mode++) {
+        const ModeRules *m = &r->modes[mode - 1];
+        printf("%s mode moves:\n", m->title);
+        if (m->aliasCount == 0) {
+            for (int i = 0; i < m->moveCount; i++) {
+                printf("%s%s%s\n", m->names[i], m->descriptions[i][0] ? " - " : "", m->descriptions[i]);
+            }
+        } else {
+            for (int a = 0; a < m->aliasCount; a++) {
+                int i = m->aliasMoves[a];
+                printf("%s - %s", m->aliases[a], m->names[i]);
+                printf(m->descriptions[i][0] ? " (%s)\n" : "\n", m->descriptions[i]);
+            }
+            printf("Or directly input the moves");
+            for (int i = 0; i < m->moveCount; i++) printf("%s %s", i ? "," : "", m->names[i]);
+            printf(".\n");
+        }
+        if (m->winRule == WIN_TABLE) {
+            printf("Scoring:\n");
+            for (int i = 0; i < m->moveCount; i++) {
+                printf("%s beats", m->names[i]);
+                int any = 0;
+                for (int j = 0; j < m->moveCount; j++) {
+                    if (m->beats[i] >> j & 1) printf("%s %s", any++ ? "," : "", m->names[j]);
+                }
+                printf(any ? "\n" : " nothing\n");
+            }
+        }
+        printf("\n");
+    }
 
     printf("How to play:\n");
     printf("- Choose your profile or create one.\n");
-    printf("- Choose basic or advanced mode.\n");
+    printf("- Choose %s or %s mode.\n", r->modes[0].title, r->modes[1].title);
     printf("- Enter moves each round.\n");
-    printf("- You win the round if your move differs from the computer's move.\n");
+    int sameRule = r->modes[0].winRule == r->modes[1].winRule;
+    for (int mode = 1; mode <= (sameRule ? 1 : 2); mode++) {
+        WinRule rule = r->modes[mode - 1].winRule;
+        printf("- ");
+        if (!sameRule) printf("%s mode: ", r->modes[mode - 1].title);
+        if (rule == WIN_DIFFER) {
+            printf("You win the round if your move differs from the computer's move.\n");
+        } else if (rule == WIN_MATCH) {
+            printf("You win the round if your move matches the computer's move.\n");
+        } else {
+            printf("Each move beats the moves listed under Scoring.\n");
+        }
+    }
     printf("- The game ends after selected rounds.\n\n");
 
     printf("Good luck and have fun!\n");
@@ -781,8 +4486,5 @@ void instructionsMenu() {
 
 
 void waitSeconds(int seconds) {
-    time_t start = time(NULL);
-    while (time(NULL) - start < seconds) {
-        // just wait
-    }
+    if (seconds > 0) sleepMillis((uint64_t)seconds * 1000);
 }
@@ -0,0 +1,692 @@
+// hrst.h - constants, types and function prototypes of the Cham Cham Cham
+// game core. hrst.c implements them; built with -DHRST_NO_MAIN it is the
+// library that benchmarks and other tools link against.
+#ifndef HRST_H
+#define HRST_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+// ----- CONSTANTS -----
+#define MAX_NAME_LEN 50
+#define INITIAL_RECORD_CAPACITY 64
+#define PROFILE_PAGE_SIZE 20
+#define PROFILE_SEARCH_LIMIT 100
+#define MAX_LINE 256
+#define DIVIDER "----------------------------------------\n"
+#define MAX_ROUNDS 20
+#define MAX_MOVE_LEN 5
+#define MOVE_BITS 3
+#define MODEL_CONTEXTS 21   // 16 two-move histories, 4 one-move, 1 empty
+#define MAX_SIM_THREADS 256
+#define MAX_ENTRANTS 65536
+#define TOURNAMENT_SHOW 20
+#define DEFAULT_SYNC_BATCH 8
+#define MAX_DURABLE_FILES 4
+#define INPUT_CHUNK 65536
+#define OUTPUT_BUFFER 65536
+#define SERVER_BACKLOG 1024
+#define SERVER_MAX_EVENTS 256
+#define SERVER_IDLE_TIMEOUT_MS 300000   // drop clients silent for 5 minutes
+#define SERVER_MOVE_TIMEOUT_MS 30000    // a move not made in 30 s is played for you
+#define TIMER_TICK_MS 100
+#define TIMER_WHEEL_SLOTS 512           // power of two; one turn of the wheel is 51.2 s
+
+#define PROFILE_FILE "profiles.dat"
+#define PROFILE_MAGIC "CHPF"
+#define PROFILE_VERSION 2
+#define BYTE_ORDER_MARK 0x01020304u
+#define HIGHSCORE_FILE "highscores.txt"
+#define TOURNAMENT_FILE "tournament.txt"  // standings of the last bot tournament
+#define LEADERBOARD_FILE "leaderboard.dat"
+#define LEADERBOARD_TOP_FILE "leaderboard.top"
+#define LEADERBOARD_MAGIC "CHLB"
+#define LEADERBOARD_TOP_MAGIC "CHTK"
+#define LEADERBOARD_VERSION 1
+#define LEADERBOARD_TOP_K 20
+#define STATS_FILE "gamestats.bin"
+#define LEGACY_STATS_FILE "gamestats.txt" // text history written before the binary log
+#define STATS_MAGIC "CHGL"
+#define STATS_VERSION 3         // 2 adds each session's seed, 3 its rule set
+#define STATS_SEED_PCG 1        // seed flags: the session used the PCG engine
+#define STATS_SEED_ADAPTIVE 2   // ... and played against the adaptive opponent
+#define STATS_READ_CHUNK 65536
+#define MAX_LOG_RECORD 256
+#define REPLAY_BATCH 65536      // sessions decoded per pass of the verifier
+#define REPLAY_REPORT 10        // mismatched sessions listed by number
+#define LOCK_FILE "hrst.lock"
+#define RULES_FILE "rules.cfg"
+#define RULES_MAX_MOVES 4       // per mode; moves are logged and modelled in 2 bits
+#define RULES_MAX_ALIASES 8     // per mode
+#define RULES_TOKEN_LEN 2       // longest move name or alias
+#define RULES_CLASSES 32        // distinct input characters + 1 (class 0 = invalid)
+#define RULES_TEXT_LEN 64
+#define RULES_MAX_SIZE 16384
+#define ANALYTICS_FILE "analytics.dat"
+#define ANALYTICS_MAGIC "CHAN"
+#define ANALYTICS_VERSION 1
+#define ANALYTICS_MONTHS 12
+
+// ----- STRUCTS -----
+
+// The eight moves. The low two bits are the move's index within its mode
+// and the third bit is set for advanced moves.
+typedef enum {
+    MOVE_NONE = -1,
+    MOVE_L, MOVE_R, MOVE_U, MOVE_D,
+    MOVE_LU, MOVE_LD, MOVE_RU, MOVE_RD
+} Move;
+
+// Header at the start of every memory-mapped data file, followed by
+// `capacity` fixed-size records of which the first `count` are in use.
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder;     // BYTE_ORDER_MARK as written by the creating machine
+    uint32_t recordSize;
+    uint32_t count;
+    uint32_t capacity;
+    uint64_t sourceOffset;  // bytes of a source log already folded in, if any
+} FileHeader;
+
+typedef struct {
+    int fd;
+    void *base;
+    size_t mapSize;
+    FileHeader *header;
+} MappedFile;
+
+// Data shared between hrst processes that use the same directory. Each has
+// a byte of LOCK_FILE to lock and a generation counter there.
+typedef enum {
+    LOCK_PROFILES,
+    LOCK_LEADERBOARD,   // leaderboard files and highscores.txt catch-up
+    LOCK_STATS,         // creating gamestats.bin
+    LOCK_ANALYTICS,
+    LOCK_RESOURCES
+} LockResource;
+
+// Adaptive opponent state: for each mode, how often the player followed each
+// recent-move context with each move. Counts are halved before overflowing,
+// so the model keeps tracking a player whose habits change.
+typedef struct {
+    uint8_t counts[2][MODEL_CONTEXTS][4];
+} OpponentModel;
+
+typedef enum {
+    OPPONENT_RANDOM,
+    OPPONENT_ADAPTIVE
+} OpponentKind;
+
+typedef struct {
+    char name[MAX_NAME_LEN];
+    int gamesPlayed;
+    int wins;
+    int losses;
+    OpponentModel model;
+} Profile;
+
+// Record layout of profile file version 1 and of headerless files
+typedef struct {
+    char name[MAX_NAME_LEN];
+    int gamesPlayed;
+    int wins;
+    int losses;
+} ProfileV1;
+
+// Open-addressing hash index from a name to a record index. Records are laid
+// out every `stride` bytes from `base` and must start with their name.
+typedef struct {
+    int *slots;         // slot -> record index, -1 when empty
+    int size;           // always a power of two, 0 until first built
+    const char *base;
+    size_t stride;
+} NameIndex;
+
+// Record numbers sorted by name. Names sharing a prefix are contiguous, so a
+// prefix lookup is two binary searches, and walking the array in order works
+// as an implicit trie for approximate matching.
+typedef struct {
+    int *ids;
+    int cap;
+    int built;          // 0 until first needed, then kept in step with the store
+} NameOrder;
+
+// Profile store: the records of profiles.dat mapped into memory, plus a name
+// index built on first lookup. Every mutation touches only its own records,
+// so nothing rewrites the file.
+typedef struct {
+    MappedFile file;
+    Profile *records;   // points into the mapping
+    int count;          // mirrors file.header->count
+    NameIndex index;
+    NameOrder order;
+    uint32_t generation;    // LOCK_PROFILES generation the index matches
+} ProfileStore;
+
+// Per-player totals folded in from every saved score
+typedef struct {
+    char name[MAX_NAME_LEN];
+    int gamesPlayed;
+    int wins;
+    int losses;
+} ScoreEntry;
+
+// Leaderboard: one ScoreEntry per player in leaderboard.dat, plus the record
+// numbers of the best LEADERBOARD_TOP_K players, kept sorted, in
+// leaderboard.top. Both are updated as each score is saved.
+typedef struct {
+    MappedFile file;
+    ScoreEntry *entries;
+    NameIndex index;
+    int indexed;        // entries this process has seen; others may append more
+    MappedFile topFile;
+    int32_t *top;
+} Leaderboard;
+
+// Random number engines. Each game thread or session owns its own Rng, so no
+// state is shared and any run can be replayed from its seed.
+typedef enum {
+    RNG_XOSHIRO,    // xoshiro256**
+    RNG_PCG         // PCG32 (XSH-RR), two outputs per 64-bit draw
+} RngEngine;
+
+typedef struct {
+    RngEngine engine;
+    uint64_t s[4];  // xoshiro: full state; PCG: s[0] state, s[1] stream increment
+} Rng;
+
+// One decoded session from the binary stats log. Moves are stored as their
+// index within the mode (0-3, see pickMove).
+typedef struct {
+    char playerName[MAX_NAME_LEN];
+    int mode;
+    int64_t timestamp;
+    int rounds;
+    int wins;
+    int losses;
+    uint8_t playerMoves[MAX_ROUNDS];
+    uint8_t compMoves[MAX_ROUNDS];
+    int seeded;                 // 0 for sessions logged before seeds were kept
+    uint64_t seed;
+    RngEngine engine;
+    OpponentKind opponent;
+    uint32_t rulesHash;         // Rules.hash of the rules the session was played under
+} LogRecord;
+
+// Streaming reader over the stats log, refilled in large chunks
+typedef struct {
+    FILE *fp;
+    unsigned char buf[STATS_READ_CHUNK];
+    size_t len;
+    size_t pos;
+    uint64_t bufStart;  // file offset of buf[0]
+    long corrupt;   // records skipped because their checksum did not match
+} LogReader;
+
+// Outcome of re-running every session in the stats log
+typedef struct {
+    long sessions;
+    long verified;      // every computer move and the score came out the same
+    long mismatched;
+    long unseeded;      // logged without a seed, so they cannot be re-run
+    long otherRules;    // played under a different rule set, so not re-run
+    long corrupt;
+    long firstBad[REPLAY_REPORT];   // session numbers (1-based) of the first mismatches
+    int badCount;
+} ReplayReport;
+
+// Everything the analytics report needs about one player, folded in from the
+// stats log one session at a time. The last ANALYTICS_MONTHS calendar months
+// played are kept in slot (month key % ANALYTICS_MONTHS).
+typedef struct {
+    char name[MAX_NAME_LEN];
+    uint32_t games;
+    uint32_t gamesWon;              // more rounds won than lost
+    uint32_t currentStreak;         // games won in a row up to the latest
+    uint32_t longestStreak;
+    uint32_t rounds[2];             // per mode: basic, advanced
+    uint32_t roundsWon[2];
+    uint32_t moves[2][4][4];        // per mode: [player move][computer move]
+    int32_t monthKey[ANALYTICS_MONTHS];     // year * 12 + month, 0 if unused
+    uint32_t monthGames[ANALYTICS_MONTHS];
+    uint32_t monthWon[ANALYTICS_MONTHS];
+} PlayerAnalytics;
+
+// Analytics cache: one PlayerAnalytics per player in analytics.dat; the
+// header's sourceOffset is how far into gamestats.bin has been folded in.
+typedef struct {
+    MappedFile file;
+    PlayerAnalytics *players;
+    NameIndex index;
+} Analytics;
+
+// Returns the raw input a scripted player would type for a round
+typedef const char *(*StrategyFn)(int mode, int round, Rng *rng);
+
+typedef struct {
+    const char *name;
+    StrategyFn nextInput;
+} Strategy;
+
+// One thread's share of a batch simulation and its results
+typedef struct {
+    const Strategy *strategy;
+    int mode;
+    int rounds;
+    long games;
+    Rng rng;
+    OpponentKind opponent;
+    OpponentModel model;        // learns across this job's games
+    long compRoundWins;
+    long wonGames;
+    long lostGames;
+    long drawnGames;
+    long roundWins[MAX_ROUNDS + 1]; // games by number of rounds won
+} SimJob;
+
+// How a tournament entrant picks its moves
+typedef enum {
+    ENTRANT_STRATEGY,   // a scripted strategy, its moves shifted by `offset`
+    ENTRANT_ADAPTIVE,   // learns its opponent's habits during each match
+    ENTRANT_PROFILE     // replays a stored profile's habits from its model
+} EntrantKind;
+
+typedef struct {
+    char name[MAX_NAME_LEN];
+    EntrantKind kind;
+    const Strategy *strategy;
+    int offset;
+    OpponentModel model;
+} Entrant;
+
+// One entrant's totals, summed over every match it played
+typedef struct {
+    long matches;
+    long matchWins;
+    long rounds;
+    long roundWins;
+    long wonRounds;     // rounds of the matches it won
+    long wonRoundWins;  // ... and how many of them it took
+} EntrantResult;
+
+typedef enum {
+    BRACKET_ROUND_ROBIN,
+    BRACKET_KNOCKOUT
+} BracketKind;
+
+// Work-stealing pool: each worker owns a range of task numbers and takes
+// tasks from its front; a worker that runs dry steals the back half of the
+// fullest range it finds.
+typedef void (*TaskFn)(void *ctx, long task, int worker);
+
+typedef struct {
+    pthread_mutex_t lock;
+    long next;
+    long end;
+} WorkRange;
+
+typedef struct {
+    WorkRange *ranges;
+    int workers;
+    TaskFn run;
+    void *ctx;
+} TaskPool;
+
+typedef struct {
+    char playerName[MAX_NAME_LEN];
+    int roundsPlayed;
+    int wins;
+    int losses;
+    uint64_t movesHistory;      // player moves, MOVE_BITS per round
+    uint64_t compMovesHistory;  // computer moves, MOVE_BITS per round
+    uint64_t seed;              // the computer's moves are drawn from this alone
+    RngEngine engine;
+    OpponentKind opponent;
+} GameSession;
+
+// Where game text goes: stdout for the console, a client's send buffer for
+// the server.
+typedef struct {
+    void (*write)(void *ctx, const char *text, size_t len);
+    void *ctx;
+} Output;
+
+// A game in progress. playGame and the server both drive one of these, so a
+// round is played, scored and reported by the same code everywhere.
+typedef struct {
+    GameSession session;
+    int mode;
+    int round;                  // rounds played so far
+    OpponentKind opponent;
+    OpponentModel model;
+    OpponentModel startModel;   // the profile's model when the game began
+    Rng rng;                    // the game's own, seeded from the caller's
+} GamePlay;
+
+typedef enum {
+    WIN_DIFFER,     // the player wins a round when the moves differ
+    WIN_MATCH,      // ... when they are the same
+    WIN_TABLE       // ... as listed by "beats" lines
+} WinRule;
+
+// One mode's moves and scoring, compiled from rules.cfg. Input is classified
+// a character at a time through Rules.charClass, so a move or alias of up to
+// two characters is one lookup in `tokens`.
+typedef struct {
+    char title[RULES_TEXT_LEN];                             // "Basic"
+    int moveCount;
+    char names[RULES_MAX_MOVES][RULES_TOKEN_LEN + 1];       // canonical, upper case
+    char descriptions[RULES_MAX_MOVES][RULES_TEXT_LEN];
+    char inputs[RULES_MAX_MOVES][RULES_TOKEN_LEN + 1];      // shortest way to type each move
+    int aliasCount;
+    char aliases[RULES_MAX_ALIASES][RULES_TOKEN_LEN + 1];
+    uint8_t aliasMoves[RULES_MAX_ALIASES];
+    WinRule winRule;
+    uint8_t beats[RULES_MAX_MOVES];     // bit c: the player's move beats the computer's move c
+    uint8_t counter[RULES_MAX_MOVES];   // the computer's answer to a predicted move
+    int8_t tokens[RULES_CLASSES][RULES_CLASSES];    // [first char][second char or 0] -> move, -1
+    char moveHint[RULES_TEXT_LEN * 2];  // "L,R,U,D" or "A=LU, ... or full LU/LD/RU/RD"
+    char keyHint[RULES_TEXT_LEN];       // "A/B/C/E"
+} ModeRules;
+
+typedef struct {
+    uint8_t charClass[256];     // case-folded; 0 for characters no move uses
+    int classCount;
+    ModeRules modes[2];
+    uint8_t playerWins[8][8];   // [player Move][computer Move]
+    uint32_t hash;              // fingerprint of what replays depend on
+} Rules;
+
+typedef char checkHistoryFits[(MAX_ROUNDS * MOVE_BITS <= 64) ? 1 : -1];
+
+// A pending timeout. Timers hash into the wheel slot of their expiry tick;
+// ones further out than a full turn share a slot and are skipped until due.
+typedef struct Timer {
+    struct Timer *next;     // NULL while not scheduled
+    struct Timer *prev;
+    uint64_t expires;       // monotonic milliseconds
+    void *owner;
+} Timer;
+
+typedef struct {
+    Timer slots[TIMER_WHEEL_SLOTS]; // list heads
+    uint64_t tick;                  // next tick to be processed
+    long count;
+} TimerWheel;
+
+typedef void (*TimerFn)(Timer *timer, void *ctx);
+
+// Where a network client is in the play flow; each state waits for one line
+typedef enum {
+    CLIENT_NAME,
+    CLIENT_MODE,
+    CLIENT_ROUNDS,
+    CLIENT_MOVE,
+    CLIENT_AGAIN
+} ClientState;
+
+typedef struct {
+    int fd;
+    ClientState state;
+    char in[MAX_LINE];
+    size_t inLen;
+    int discarding;     // dropping the rest of an over-long line
+    char *out;
+    size_t outLen;
+    size_t outCap;
+    int closing;        // disconnect once output is flushed
+    Output output;      // appends to out
+    char name[MAX_NAME_LEN];
+    int mode;           // picked for the next game
+    GamePlay game;
+    Timer timer;        // move deadline while playing, idle timeout otherwise
+} ClientSession;
+
+// Event-driven server: one thread multiplexes every client, so the shared
+// profile store and leaderboard are only ever touched by one caller.
+typedef struct {
+    int listenFd;
+    int eventFd;                // epoll instance (Linux only)
+    ClientSession **clients;    // indexed by fd
+    int clientCap;
+    long clientCount;
+    long acceptedTotal;
+    ProfileStore *store;
+    Leaderboard *lb;
+    Rng rng;
+    OpponentKind opponent;
+    TimerWheel timers;
+    int stopFd;                 // read end of the shutdown self-pipe
+} Server;
+
+// Probes. Built with -DHRST_METRICS, every timed path keeps a call count, a
+// total and a log2 latency histogram, and counters track work done; without
+// it the probe macros expand to nothing.
+typedef enum {
+    TIMER_INPUT_WAIT,           // blocked in read() for menu input
+    TIMER_PROFILE_LOAD,
+    TIMER_PROFILE_SAVE,
+    TIMER_SCORE_SAVE,
+    TIMER_LEADERBOARD_CATCH_UP,
+    TIMER_SCOREBOARD_RENDER,
+    TIMER_STATS_SAVE,
+    TIMER_GAME_RECORD,          // everything saved after one game
+    TIMER_DURABLE_SYNC,
+    TIMER_ANALYTICS_REFRESH,
+    TIMER_LOCK_WAIT,            // waiting for another process's file lock
+    TIMER_COUNT
+} MetricTimer;
+
+typedef enum {
+    COUNTER_INPUT_LINES,
+    COUNTER_INPUT_READS,
+    COUNTER_BYTES_APPENDED,
+    COUNTER_FSYNCS,
+    COUNTER_SCORE_LINES_FOLDED,
+    COUNTER_LOG_RECORDS_FOLDED,
+    COUNTER_GAMES_RECORDED,
+    COUNTER_COUNT
+} MetricCounter;
+
+#define METRIC_BUCKETS 40   // bucket b holds latencies below 2^(b+1) ns
+
+typedef struct {
+    uint64_t count;
+    uint64_t sumNs;
+    uint64_t buckets[METRIC_BUCKETS];
+} TimerMetric;
+
+#ifdef HRST_METRICS
+#define METRIC_TIMER_START(var) uint64_t var = metricNow()
+#define METRIC_TIMER_STOP(var, timer) metricObserve((timer), metricNow() - (var))
+#define METRIC_ADD(counter, n) metricAdd((counter), (uint64_t)(n))
+#else
+#define METRIC_TIMER_START(var) ((void)0)
+#define METRIC_TIMER_STOP(var, timer) ((void)0)
+#define METRIC_ADD(counter, n) ((void)0)
+#endif
+
+// ----- FUNCTION PROTOTYPES -----
+
+// Input and output
+int openReplay(const char *path);
+char *inputLine(void);
+void endOfInput(void);
+int readLine(char *buffer, int length);
+int getIntInRange(const char *prompt, int min, int max);
+int confirmYesNo(const char *prompt);
+void toUpperStr(char *str);
+void pauseProgram();
+void printHeader(const char *title);
+void printFooter();
+void printDivider();
+void printEmptyLines(int count);
+
+// Metrics
+uint64_t metricNow(void);
+void metricObserve(MetricTimer timer, uint64_t ns);
+void metricAdd(MetricCounter counter, uint64_t n);
+int metricsSetFormat(const char *format);
+void metricsDump(void);
+
+// Durable storage
+int durableOpenAppend(const char *path);
+int durableWrite(const char *path, const void *data, size_t len);
+void durableSetBatch(int games);
+void durableAttach(ProfileStore *store, Leaderboard *lb);
+void durableGameDone(void);
+void durableSync(void);
+void durableShutdown(void);
+int atomicReplaceFile(FILE *tmp, const char *tmpPath, const char *path);
+
+// Memory-mapped files
+int mapOpen(MappedFile *mf, const char *path, const char *magic, uint32_t version, uint32_t recordSize);
+int mapReserve(MappedFile *mf, uint32_t capacity);
+int mapRefresh(MappedFile *mf);
+void *mapRecords(MappedFile *mf);
+
+// Process locks
+int processLock(LockResource resource, int exclusive);
+void processUnlock(LockResource resource);
+uint32_t lockGeneration(LockResource resource);
+void lockBumpGeneration(LockResource resource);
+void mapClose(MappedFile *mf);
+
+// Profile store
+int loadProfiles(ProfileStore *store);
+void closeProfiles(ProfileStore *store);
+int storeLock(ProfileStore *store, int exclusive);
+void storeUnlock(ProfileStore *store);
+int saveProfile(ProfileStore *store, int idx);
+int findProfileIndex(ProfileStore *store, const char *name);
+int storeAddProfile(ProfileStore *store, const Profile *p);
+int storeRenameProfile(ProfileStore *store, int idx, const char *newName);
+int storeDeleteProfile(ProfileStore *store, int idx);
+
+// Profile search
+int profilePrefixSearch(ProfileStore *store, const char *prefix, int *first);
+int profileFuzzySearch(ProfileStore *store, const char *query, int maxDist, int *out, int maxOut);
+int selectProfile(ProfileStore *store, const char *action);
+
+// Profile management
+void addNewProfile(ProfileStore *store);
+void renameProfile(ProfileStore *store);
+void deleteProfile(ProfileStore *store);
+void viewProfileDetails(Profile *p);
+void updateProfileStats(Profile *p, GameSession *session);
+void recordGameResult(ProfileStore *store, Leaderboard *lb, GameSession *session, int mode,
+                      const OpponentModel *startModel, const OpponentModel *model);
+
+// Game rules
+int loadRules(const char *path);
+const Rules *gameRules(void);
+int moveCount(int mode);
+const char *modeName(int mode);
+
+// Game logic
+void playGame(ProfileStore *store, Leaderboard *lb, Rng *rng, OpponentKind opponent);
+int isValidMove(const char *move, int mode);
+const char *moveToString(Move move);
+void setHistoryMove(uint64_t *history, int round, Move move);
+Move getHistoryMove(uint64_t history, int round);
+Move parseMove(const char *input, int mode);
+Move pickMove(int mode, int choice);
+Move computerMove(Rng *rng, int mode);
+Move predictMove(const OpponentModel *model, Rng *rng, int mode, uint64_t history, int round);
+void seedSession(GameSession *session, Rng *game, Rng *source, OpponentKind opponent);
+Move opponentMove(const OpponentModel *model, Rng *rng, int mode, uint64_t history, int round);
+void modelLearn(OpponentModel *model, int mode, uint64_t history, int round, Move actual);
+void modelMerge(OpponentModel *target, const OpponentModel *before, const OpponentModel *after);
+int scoreRound(Move playerMove, Move compMove);
+void outPrintf(Output *out, const char *fmt, ...);
+void gameBegin(GamePlay *game, ProfileStore *store, Rng *source, OpponentKind opponent,
+               const char *name, int mode, int rounds);
+void gamePrompt(const GamePlay *game, Output *out);
+int gamePlayRound(GamePlay *game, Move playerMove, Output *out);
+void gameFinish(GamePlay *game, ProfileStore *store, Leaderboard *lb, Output *out);
+
+// Random numbers
+void rngSeed(Rng *rng, RngEngine engine, uint64_t seed);
+void rngSplit(Rng *child, const Rng *parent, int stream);
+uint64_t rngNext(Rng *rng);
+uint32_t rngBounded(Rng *rng, uint32_t bound);
+void rngFillMoves(Rng *rng, uint8_t *moves, int count);
+uint64_t defaultSeed(void);
+
+// Timers
+uint64_t monotonicMillis(void);
+void sleepMillis(uint64_t ms);
+void timerWheelInit(TimerWheel *wheel, uint64_t now);
+void timerSchedule(TimerWheel *wheel, Timer *timer, uint64_t expires);
+void timerCancel(TimerWheel *wheel, Timer *timer);
+void timerWheelAdvance(TimerWheel *wheel, uint64_t now, TimerFn fire, void *ctx);
+int timerWheelNextDelay(const TimerWheel *wheel, uint64_t now);
+
+// Batch simulation
+const Strategy *findStrategy(const char *name);
+void *simulateGames(void *arg);
+int runSimulation(const Rng *rng, OpponentKind opponent, const char *strategyName, int mode, int rounds,
+                  long games, int threads);
+int benchmarkOpponent(const Rng *rng, long games);
+
+// Tournament
+int poolRun(long tasks, int threads, TaskFn run, void *ctx);
+int runTournament(ProfileStore *store, Leaderboard *lb, const Rng *rng, int bots, BracketKind bracket,
+                  int mode, int rounds, int threads);
+void tournamentMenu(ProfileStore *store, Leaderboard *lb, Rng *rng);
+
+// Leaderboard
+int openLeaderboard(Leaderboard *lb);
+void closeLeaderboard(Leaderboard *lb);
+int leaderboardRecord(Leaderboard *lb, const char *name, int games, int wins, int losses);
+int leaderboardCatchUp(Leaderboard *lb);
+
+// Scoreboard
+void saveScoreToFile(Leaderboard *lb, GameSession *session);
+int writeScoreboard(Leaderboard *lb, Output *out);
+void displayScoreboard(Leaderboard *lb);
+
+// Stats Logging
+uint32_t crc32(const unsigned char *data, size_t len);
+void saveGameStats(GameSession *session, int mode);
+int logReaderOpen(LogReader *reader, const char *path);
+int logReaderSeek(LogReader *reader, uint64_t offset);
+uint64_t logReaderOffset(const LogReader *reader);
+int logReaderNext(LogReader *reader, LogRecord *rec);
+void logReaderClose(LogReader *reader);
+void viewGameStats();
+
+// Session replay
+int replaySession(const LogRecord *rec, OpponentModel *model, uint8_t *compMoves);
+int verifyLog(const char *path, int threads, ReplayReport *report);
+int runVerifyLog(int threads);
+int showSession(long number);
+void replaySessionMenu();
+
+// Player analytics
+int openAnalytics(Analytics *an);
+void closeAnalytics(Analytics *an);
+long analyticsCatchUp(Analytics *an);
+const PlayerAnalytics *analyticsFind(Analytics *an, const char *name);
+void showPlayerAnalytics(const PlayerAnalytics *pa);
+void showAnalyticsSummary(const Analytics *an);
+int runAnalytics(const char *name);
+void viewPlayerAnalytics();
+
+// Game server
+int runServer(const char *address, ProfileStore *store, Leaderboard *lb, Rng *rng, OpponentKind opponent);
+
+// Menu and interface
+void mainMenu(ProfileStore *store, Leaderboard *lb, Rng *rng, OpponentKind opponent);
+void profilesMenu(ProfileStore *store);
+void scoreboardMenu(Leaderboard *lb);
+void statsMenu();
+void instructionsMenu();
+
+// Helper for long line printing and delays
+void waitSeconds(int seconds);
+
+#endif // HRST_H